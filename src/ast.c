@@ -7,13 +7,59 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * Arena allocation.
+ */
+struct ast_arena_block {
+    struct ast_arena_block *prev;
+    union value_data align;
+};
+
+#define AST_ARENA_ALIGN sizeof(union value_data)
+
+void ast_arena_init(struct ast_arena *arena)
+{
+    arena->next = (char *)arena->first;
+    arena->end = (char *)arena->first + sizeof(arena->first);
+    arena->blocks = NULL;
+}
+
+void *ast_arena_alloc(struct ast_arena *arena, size_t size)
+{
+    char *p;
+    size = (size + AST_ARENA_ALIGN-1) / AST_ARENA_ALIGN * AST_ARENA_ALIGN;
+    if ((size_t)(arena->end - arena->next) < size) {
+        struct ast_arena_block *block;
+        size_t block_size = (size < AST_ARENA_BLOCK) ? AST_ARENA_BLOCK : size;
+        if (!(block = malloc(sizeof(struct ast_arena_block) + block_size)))
+            return NULL;
+        block->prev = arena->blocks;
+        arena->blocks = block;
+        arena->next = (char *)(block + 1);
+        arena->end = arena->next + block_size;
+    }
+    p = arena->next;
+    arena->next += size;
+    return p;
+}
+
+void ast_arena_reset(struct ast_arena *arena)
+{
+    while (arena->blocks) {
+        struct ast_arena_block *prev = arena->blocks->prev;
+        free(arena->blocks);
+        arena->blocks = prev;
+    }
+    ast_arena_init(arena);
+}
+
 /*
  * AST allocation and initialization functions.
  */
-struct ast *ast_value_new(struct value *value)
+struct ast *ast_value_new(struct ast_arena *a, struct value *value)
 {
     struct ast_value *n;
-    if ((n = malloc(sizeof(struct ast_value)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_value)))) {
         n->tree.node_type = AST_VALUE;
         n->tree.value_type = value->type;
         n->value = *value;
@@ -21,10 +67,11 @@ struct ast *ast_value_new(struct value *value)
     return (struct ast *)n;
 }
 
-struct ast *ast_var_new(struct symbol_table *symtab, size_t sym, size_t size)
+struct ast *ast_var_new(struct ast_arena *a, struct symbol_table *symtab,
+                        size_t sym, size_t size)
 {
     struct ast_var *n;
-    if ((n = malloc(sizeof(struct ast_var)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_var)))) {
         n->tree.node_type = AST_VAR;
         n->tree.value_type = symtab->symbols[sym]->type;
         n->symtab = symtab;
@@ -34,10 +81,11 @@ struct ast *ast_var_new(struct symbol_table *symtab, size_t sym, size_t size)
     return (struct ast *)n;
 }
 
-struct ast *ast_cast_new(enum value_type value_type, struct ast *child)
+struct ast *ast_cast_new(struct ast_arena *a, enum value_type value_type,
+                         struct ast *child)
 {
     struct ast_cast *n;
-    if ((n = malloc(sizeof(struct ast_cast)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_cast)))) {
         ((struct ast *)n)->node_type = AST_CAST;
         ((struct ast *)n)->value_type = value_type;
         ((struct ast_unary *)n)->child = child;
@@ -45,11 +93,11 @@ struct ast *ast_cast_new(enum value_type value_type, struct ast *child)
     return (struct ast *)n;
 }
 
-struct ast *ast_deref_new(struct ast *child, enum value_type value_type,
-                          struct target *target)
+struct ast *ast_deref_new(struct ast_arena *a, struct ast *child,
+                          enum value_type value_type, struct target *target)
 {
     struct ast_deref *n;
-    if ((n = malloc(sizeof(struct ast_deref)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_deref)))) {
         ((struct ast *)n)->node_type = AST_DEREF;
         ((struct ast *)n)->value_type = value_type;
         ((struct ast_unary *)n)->child = child;
@@ -58,21 +106,22 @@ struct ast *ast_deref_new(struct ast *child, enum value_type value_type,
     return (struct ast *)n;
 }
 
-struct ast *ast_unary_new(enum ast_type node_type, struct ast *child)
+struct ast *ast_unary_new(struct ast_arena *a, enum ast_type node_type,
+                          struct ast *child)
 {
     struct ast_unary *n;
-    if ((n = malloc(sizeof(struct ast_unary)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_unary)))) {
         n->tree.node_type = node_type;
         n->child = child;
     }
     return (struct ast *)n;
 }
 
-struct ast *ast_binary_new(enum ast_type node_type,
+struct ast *ast_binary_new(struct ast_arena *a, enum ast_type node_type,
                            struct ast *left, struct ast *right)
 {
     struct ast_binary *n;
-    if ((n = malloc(sizeof(struct ast_binary)))) {
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_binary)))) {
         n->tree.node_type = node_type;
         n->left = left;
         n->right = right;
@@ -80,59 +129,291 @@ struct ast *ast_binary_new(enum ast_type node_type,
     return (struct ast *)n;
 }
 
-/*
- * Delete.
- */
-static void ast_leaf_delete(struct ast *this)
+struct ast *ast_isptr_new(struct ast_arena *a, struct ast *child,
+                          struct region_table *table)
 {
-    free(this);
+    struct ast_isptr *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_isptr)))) {
+        ((struct ast *)n)->node_type = AST_ISPTR;
+        ((struct ast *)n)->value_type = S32;
+        ((struct ast_unary *)n)->child = child;
+        n->table = table;
+    }
+    return (struct ast *)n;
 }
 
-static void ast_unary_delete(struct ast *this)
+struct ast *ast_inregion_new(struct ast_arena *a, struct ast *child,
+                             struct region_table *table,
+                             const char *pattern, size_t len)
+{
+    struct ast_inregion *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_inregion)))) {
+        if ((n->pattern = ast_arena_alloc(a, len + 1))) {
+            memcpy(n->pattern, pattern, len);
+            n->pattern[len] = '\0';
+            ((struct ast *)n)->node_type = AST_INREGION;
+            ((struct ast *)n)->value_type = S32;
+            ((struct ast_unary *)n)->child = child;
+            n->table = table;
+            n->arena = a;
+            n->generation = 0;
+            n->matches = NULL;
+            n->matches_size = 0;
+        } else {
+            n = NULL;
+        }
+    }
+    return (struct ast *)n;
+}
+
+struct ast *ast_near_new(struct ast_arena *a, struct ast *child,
+                         struct ast *center, struct ast *tolerance,
+                         enum value_near mode)
 {
-    ast_delete(((struct ast_unary *)this)->child);
-    free(this);
+    struct ast_near *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_near)))) {
+        ((struct ast *)n)->node_type = AST_NEAR;
+        ((struct ast *)n)->value_type = S32;
+        ((struct ast_unary *)n)->child = child;
+        n->center = center;
+        n->tolerance = tolerance;
+        n->mode = mode;
+        n->bounded = 0;
+    }
+    return (struct ast *)n;
+}
+
+struct ast *ast_within_new(struct ast_arena *a, struct ast *child,
+                           struct target *target, enum value_type type,
+                           struct ast **elements, size_t size,
+                           struct ast *radius, struct ast *stride)
+{
+    struct ast_within *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_within)))) {
+        if ((n->elements = ast_arena_alloc(a, size * sizeof(struct ast *)))) {
+            memcpy(n->elements, elements, size * sizeof(struct ast *));
+            ((struct ast *)n)->node_type = AST_WITHIN;
+            ((struct ast *)n)->value_type = S32;
+            ((struct ast_unary *)n)->child = child;
+            n->target = target;
+            n->type = type;
+            n->size = size;
+            n->radius = radius;
+            n->stride = stride;
+            n->center = NULL;
+            n->radius2 = 0;
+            n->step = 0;
+        } else {
+            n = NULL;
+        }
+    }
+    return (struct ast *)n;
+}
+
+struct ast *ast_bytes_new(struct ast_arena *a, struct ast *child,
+                          struct target *target, const unsigned char *pattern,
+                          const unsigned char *mask, size_t size)
+{
+    struct ast_bytes *n;
+    size_t i;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_bytes)))) {
+        if ((n->pattern = ast_arena_alloc(a, 2*size))) {
+            n->mask = n->pattern + size;
+            memcpy(n->pattern, pattern, size);
+            memcpy(n->mask, mask, size);
+            ((struct ast *)n)->node_type = AST_BYTES;
+            ((struct ast *)n)->value_type = S32;
+            ((struct ast_unary *)n)->child = child;
+            n->target = target;
+            n->size = size;
+
+            /* Anchor on a byte other than the common 0x00 and 0xff */
+            for (n->anchor = size, i = 0; i < size; i++) {
+                if (mask[i] == 0xff) {
+                    if (pattern[i] != 0x00 && pattern[i] != 0xff) {
+                        n->anchor = i;
+                        break;
+                    }
+                    if (n->anchor == size)
+                        n->anchor = i;
+                }
+            }
+        } else {
+            n = NULL;
+        }
+    }
+    return (struct ast *)n;
 }
 
-static void ast_binary_delete(struct ast *this)
+struct ast *ast_in_new(struct ast_arena *a, struct ast *child,
+                       struct ast **elements, size_t size)
 {
-    ast_delete(((struct ast_binary *)this)->left);
-    ast_delete(((struct ast_binary *)this)->right);
-    free(this);
+    struct ast_in *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_in)))) {
+        if ((n->elements = ast_arena_alloc(a, size * sizeof(struct ast *)))) {
+            memcpy(n->elements, elements, size * sizeof(struct ast *));
+            ((struct ast *)n)->node_type = AST_IN;
+            ((struct ast *)n)->value_type = S32;
+            ((struct ast_unary *)n)->child = child;
+            n->size = size;
+            n->members = NULL;
+            n->members_size = 0;
+        } else {
+            n = NULL;
+        }
+    }
+    return (struct ast *)n;
 }
 
-void (*ast_delete_funcs[AST_TYPES])(struct ast *) = {
-    /* AST_VALUE */ ast_leaf_delete,
-    /* AST_VAR   */ ast_leaf_delete,
+struct ast *ast_memo_new(struct ast_arena *a, struct ast *child,
+                         struct ast_scope *scope)
+{
+    struct ast_memo *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_memo)))) {
+        ((struct ast *)n)->node_type = AST_MEMO;
+        ((struct ast *)n)->value_type = child->value_type;
+        ((struct ast_unary *)n)->child = child;
+        n->scope = scope;
+        n->generation = 0;
+        n->ok = 0;
+    }
+    return (struct ast *)n;
+}
 
-    /* AST_CAST  */ ast_unary_delete,
-    /* AST_DEREF */ ast_unary_delete,
-    /* AST_NEG   */ ast_unary_delete,
-    /* AST_NOT   */ ast_unary_delete,
-    /* AST_COMPL */ ast_unary_delete,
+struct ast *ast_scope_new(struct ast_arena *a, struct ast *child)
+{
+    struct ast_scope *n;
+    if ((n = ast_arena_alloc(a, sizeof(struct ast_scope)))) {
+        ((struct ast *)n)->node_type = AST_SCOPE;
+        ((struct ast *)n)->value_type = child ? child->value_type : S32;
+        ((struct ast_unary *)n)->child = child;
+        n->generation = 1;
+    }
+    return (struct ast *)n;
+}
 
-    /* AST_ADD */ ast_binary_delete,
-    /* AST_SUB */ ast_binary_delete,
-    /* AST_MUL */ ast_binary_delete,
-    /* AST_DIV */ ast_binary_delete,
-    /* AST_MOD */ ast_binary_delete,
+/*
+ * AST copying.
+ */
+struct ast *ast_copy(struct ast_arena *a, struct ast *ast, size_t bound)
+{
+    struct ast *copy, *left, *right;
 
-    /* AST_AND */ ast_binary_delete,
-    /* AST_XOR */ ast_binary_delete,
-    /* AST_OR  */ ast_binary_delete,
-    /* AST_SHL */ ast_binary_delete,
-    /* AST_SHR */ ast_binary_delete,
+    if (ast->node_type == AST_MEMO || ast->node_type == AST_SCOPE)
+        return ast_copy(a, ((struct ast_unary *)ast)->child, bound);
 
-    /* AST_EQ  */ ast_binary_delete,
-    /* AST_NEQ */ ast_binary_delete,
-    /* AST_LT  */ ast_binary_delete,
-    /* AST_GT  */ ast_binary_delete,
-    /* AST_LE  */ ast_binary_delete,
-    /* AST_GE  */ ast_binary_delete,
+    left = right = NULL;
+    if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        struct ast_binary *binary = (struct ast_binary *)ast;
+        if (!(left = ast_copy(a, binary->left, bound))
+                || !(right = ast_copy(a, binary->right, bound))) {
+            return NULL;
+        }
+    } else if (ast->node_type >= AST_CAST) {
+        if (!(left = ast_copy(a, ((struct ast_unary *)ast)->child, bound)))
+            return NULL;
+    }
 
-    /* AST_AND_COND */ ast_binary_delete,
-    /* AST_OR_COND  */ ast_binary_delete
-};
+    switch (ast->node_type) {
+    case AST_VALUE:
+        copy = ast_value_new(a, &((struct ast_value *)ast)->value);
+        break;
+    case AST_VAR: {
+        struct ast_var *var = (struct ast_var *)ast;
+        if (bound && var->sym >= bound) {
+            struct value value;
+            value.type = ast->value_type;
+            memcpy(&value.data, var->symtab->symbols[var->sym]->pdata,
+                   var->size);
+            copy = ast_value_new(a, &value);
+        } else {
+            copy = ast_var_new(a, var->symtab, var->sym, var->size);
+        }
+        break;
+    }
+    case AST_CAST:
+        return ast_cast_new(a, ast->value_type, left);
+    case AST_DEREF:
+        return ast_deref_new(a, left, ast->value_type,
+                             ((struct ast_deref *)ast)->target);
+    case AST_ISPTR:
+        return ast_isptr_new(a, left, ((struct ast_isptr *)ast)->table);
+    case AST_INREGION: {
+        struct ast_inregion *inregion = (struct ast_inregion *)ast;
+        return ast_inregion_new(a, left, inregion->table, inregion->pattern,
+                                strlen(inregion->pattern));
+    }
+    case AST_NEAR: {
+        struct ast_near *near = (struct ast_near *)ast, *n;
+        struct ast *center, *tolerance;
+        if (!(center = ast_copy(a, near->center, bound))
+                || !(tolerance = ast_copy(a, near->tolerance, bound))
+                || !(n = (struct ast_near *)ast_near_new(a, left, center,
+                                                         tolerance,
+                                                         near->mode))) {
+            return NULL;
+        }
+        n->bounded = near->bounded;
+        n->lo = near->lo;
+        n->hi = near->hi;
+        return (struct ast *)n;
+    }
+    case AST_WITHIN: {
+        struct ast_within *within = (struct ast_within *)ast, *n;
+        struct ast *radius, *stride;
+        size_t i, size;
+        if (!(radius = ast_copy(a, within->radius, bound))
+                || !(stride = ast_copy(a, within->stride, bound))
+                || !(n = (struct ast_within *)ast_within_new(a, left,
+                                within->target, within->type, within->elements,
+                                within->size, radius, stride))) {
+            return NULL;
+        }
+        for (i = 0; i < within->size; i++) {
+            if (!(n->elements[i] = ast_copy(a, within->elements[i], bound)))
+                return NULL;
+        }
+        if (within->center) {
+            size = within->size * sizeof(double);
+            if (!(n->center = ast_arena_alloc(a, size)))
+                return NULL;
+            memcpy(n->center, within->center, size);
+            n->radius2 = within->radius2;
+            n->step = within->step;
+        }
+        return (struct ast *)n;
+    }
+    case AST_BYTES: {
+        struct ast_bytes *bytes = (struct ast_bytes *)ast;
+        return ast_bytes_new(a, left, bytes->target, bytes->pattern,
+                             bytes->mask, bytes->size);
+    }
+    case AST_IN: {
+        struct ast_in *in = (struct ast_in *)ast, *n;
+        size_t i, size = in->members ? 0 : in->size;
+        if (!(n = (struct ast_in *)ast_in_new(a, left, in->elements, size)))
+            return NULL;
+        for (i = 0; i < size; i++) {
+            if (!(n->elements[i] = ast_copy(a, in->elements[i], bound)))
+                return NULL;
+        }
+        if (in->members) {
+            size = in->members_size * sizeof(union value_data);
+            if (!(n->members = ast_arena_alloc(a, size)))
+                return NULL;
+            memcpy(n->members, in->members, size);
+            n->members_size = in->members_size;
+        }
+        return (struct ast *)n;
+    }
+    default:
+        copy = right ? ast_binary_new(a, ast->node_type, left, right)
+                     : ast_unary_new(a, ast->node_type, left);
+        break;
+    }
+    if (copy) copy->value_type = ast->value_type;
+    return copy;
+}
 
 /*
  * AST printing.
@@ -362,6 +643,152 @@ static size_t ast_or_cond_snprint(struct ast *this, char *out, size_t size)
     return ast_binary_snprint(this, "||", out, size);
 }
 
+static size_t ast_isptr_snprint(struct ast *this, char *out, size_t size)
+{
+    return ast_unary_snprint(this, "isptr", out, size);
+}
+
+static size_t ast_inregion_snprint(struct ast *this, char *out, size_t size)
+{
+    size_t len = 0;
+    struct ast *child = ((struct ast_unary *)this)->child;
+    const char *pattern = ((struct ast_inregion *)this)->pattern;
+    if (size && len < size-1) {
+        len += ast_snprint(child, out, size);
+    } else len += ast_snprint(child, NULL, 0);
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " \"%s\" inregion", pattern);
+    else len += snprintf(NULL, 0, " \"%s\" inregion", pattern);
+    return len;
+}
+
+static size_t ast_near_snprint(struct ast *this, char *out, size_t size)
+{
+    static const char *const names[] = { "approx", "ulps", "rounds" };
+    struct ast_near *near = (struct ast_near *)this;
+    struct ast *operands[3];
+    size_t i, len = 0;
+    operands[0] = near->tree.child;
+    operands[1] = near->center;
+    operands[2] = near->tolerance;
+    for (i = 0; i < 3; i++) {
+        if (i) {
+            if (size && len < size-1)
+                len += snprintf(out+len, size-len, " ");
+            else len += snprintf(NULL, 0, " ");
+        }
+        if (size && len < size-1)
+            len += ast_snprint(operands[i], out+len, size-len);
+        else len += ast_snprint(operands[i], NULL, 0);
+    }
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " %s", names[near->mode]);
+    else len += snprintf(NULL, 0, " %s", names[near->mode]);
+    return len;
+}
+
+static size_t ast_within_snprint(struct ast *this, char *out, size_t size)
+{
+    size_t i, len = 0;
+    struct ast_within *within = (struct ast_within *)this;
+    const char *type = value_type_to_string(within->type);
+    if (size && len < size-1) {
+        len += ast_snprint(within->tree.child, out, size);
+    } else len += ast_snprint(within->tree.child, NULL, 0);
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " (%s*)", type);
+    else len += snprintf(NULL, 0, " (%s*)", type);
+
+    for (i = 0; i < within->size; i++) {
+        const char *sep = i ? ", " : " {";
+        if (size && len < size-1)
+            len += snprintf(out+len, size-len, "%s", sep);
+        else len += snprintf(NULL, 0, "%s", sep);
+        if (size && len < size-1)
+            len += ast_snprint(within->elements[i], out+len, size-len);
+        else len += ast_snprint(within->elements[i], NULL, 0);
+    }
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, "} ");
+    else len += snprintf(NULL, 0, "} ");
+
+    if (size && len < size-1)
+        len += ast_snprint(within->radius, out+len, size-len);
+    else len += ast_snprint(within->radius, NULL, 0);
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " ");
+    else len += snprintf(NULL, 0, " ");
+    if (size && len < size-1)
+        len += ast_snprint(within->stride, out+len, size-len);
+    else len += ast_snprint(within->stride, NULL, 0);
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " within");
+    else len += snprintf(NULL, 0, " within");
+    return len;
+}
+
+static size_t ast_bytes_snprint(struct ast *this, char *out, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    struct ast_bytes *bytes = (struct ast_bytes *)this;
+    char text[3*AST_BYTES_MAX + 1], *p;
+    size_t i, len = 0;
+
+    for (p = text, i = 0; i < bytes->size; i++) {
+        unsigned char byte = bytes->pattern[i], mask = bytes->mask[i];
+        if (i) *p++ = ' ';
+        *p++ = (mask & 0xf0) ? digits[byte >> 4] : '?';
+        *p++ = (mask & 0x0f) ? digits[byte & 0x0f] : '?';
+    }
+    *p = '\0';
+
+    if (size && len < size-1) {
+        len += ast_snprint(bytes->tree.child, out, size);
+    } else len += ast_snprint(bytes->tree.child, NULL, 0);
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, " \"%s\" bytes", text);
+    else len += snprintf(NULL, 0, " \"%s\" bytes", text);
+    return len;
+}
+
+static size_t ast_in_snprint(struct ast *this, char *out, size_t size)
+{
+    size_t i, n, len = 0;
+    struct ast_in *in = (struct ast_in *)this;
+    if (size && len < size-1) {
+        len += ast_snprint(in->tree.child, out, size);
+    } else len += ast_snprint(in->tree.child, NULL, 0);
+
+    n = in->members ? in->members_size : in->size;
+    for (i = 0; i < n; i++) {
+        const char *sep = i ? ", " : " {";
+        if (size && len < size-1)
+            len += snprintf(out+len, size-len, "%s", sep);
+        else len += snprintf(NULL, 0, "%s", sep);
+        if (in->members) {
+            struct value value;
+            value.type = in->tree.child->value_type;
+            value.data = in->members[i];
+            if (size && len < size-1)
+                len += value_to_string(&value, out+len, size-len);
+            else len += value_to_string(&value, NULL, 0);
+        } else if (size && len < size-1) {
+            len += ast_snprint(in->elements[i], out+len, size-len);
+        } else len += ast_snprint(in->elements[i], NULL, 0);
+    }
+
+    if (size && len < size-1)
+        len += snprintf(out+len, size-len, "%s in", n ? "}" : " {}");
+    else len += snprintf(NULL, 0, "%s in", n ? "}" : " {}");
+    return len;
+}
+
+/* Shared subexpressions are printed at each of their occurrences */
+static size_t ast_memo_snprint(struct ast *this, char *out, size_t size)
+{
+    return ast_snprint(((struct ast_unary *)this)->child, out, size);
+}
+
 size_t (*ast_snprint_funcs[AST_TYPES])(struct ast *, char *, size_t) = {
     /* AST_VALUE */ ast_value_snprint,
     /* AST_VAR   */ ast_var_snprint,
@@ -392,5 +819,16 @@ size_t (*ast_snprint_funcs[AST_TYPES])(struct ast *, char *, size_t) = {
     /* AST_GE  */ ast_ge_snprint,
 
     /* AST_AND_COND */ ast_and_cond_snprint,
-    /* AST_OR_COND  */ ast_or_cond_snprint
+    /* AST_OR_COND  */ ast_or_cond_snprint,
+
+    /* AST_ISPTR    */ ast_isptr_snprint,
+    /* AST_INREGION */ ast_inregion_snprint,
+    /* AST_NEAR     */ ast_near_snprint,
+    /* AST_WITHIN   */ ast_within_snprint,
+    /* AST_BYTES    */ ast_bytes_snprint,
+
+    /* AST_IN */ ast_in_snprint,
+
+    /* AST_MEMO  */ ast_memo_snprint,
+    /* AST_SCOPE */ ast_memo_snprint
 };
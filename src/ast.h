@@ -9,6 +9,34 @@
 
 #include <stddef.h>
 
+/*
+ * Bump-pointer arena of AST nodes.
+ *
+ * All nodes of an expression are allocated from an arena. The parser creates
+ * children before their parents, so nodes are laid out contiguously in the
+ * order of evaluation. Nodes are never freed individually: the whole tree is
+ * torn down by resetting the arena. The first AST_ARENA_INLINE bytes come
+ * from the arena structure itself, so a typical expression parsed into an
+ * arena on the stack allocates no memory at all.
+ */
+#define AST_ARENA_INLINE 2048
+#define AST_ARENA_BLOCK 16384
+
+struct ast_arena {
+    char *next, *end;
+    struct ast_arena_block *blocks;
+    union value_data first[AST_ARENA_INLINE / sizeof(union value_data)];
+};
+
+/* Initialize an empty arena */
+void ast_arena_init(struct ast_arena *arena);
+
+/* Allocate `size` bytes suitably aligned for any AST node (NULL on error) */
+void *ast_arena_alloc(struct ast_arena *arena, size_t size);
+
+/* Free all nodes allocated from an arena (and the memory it allocated) */
+void ast_arena_reset(struct ast_arena *arena);
+
 /*
  * AST node types.
  *
@@ -32,6 +60,15 @@ enum ast_type {
     /* Conditional operators */
     AST_AND_COND, AST_OR_COND,
 
+    /* Builtin functions */
+    AST_ISPTR, AST_INREGION, AST_NEAR, AST_WITHIN, AST_BYTES,
+
+    /* Set membership */
+    AST_IN,
+
+    /* Shared subexpressions */
+    AST_MEMO, AST_SCOPE,
+
     AST_TYPES
 };
 #define lex_to_ast_type(lex_token_type) ((lex_token_type) + AST_ADD-LEX_ADD)
@@ -46,9 +83,10 @@ struct ast {
 };
 
 #define ast_is_constant(ast) ((ast)->node_type < AST_VAR)
-#define ast_is_compare(ast) ((ast)->node_type >= AST_EQ)
-#define ast_type_is_compare(type) ((type) >= AST_EQ)
-#define ast_type_is_conditional(type) ((type) >= AST_AND_COND)
+#define ast_is_compare(ast) ast_type_is_compare((ast)->node_type)
+#define ast_type_is_compare(type) ((type) >= AST_EQ && (type) <= AST_OR_COND)
+#define ast_type_is_conditional(type) \
+    ((type) >= AST_AND_COND && (type) <= AST_OR_COND)
 
 struct ast_binary {
     struct ast tree;
@@ -107,48 +145,175 @@ struct ast_ge  { struct ast_binary tree; };
 struct ast_and_cond { struct ast_binary tree; };
 struct ast_or_cond  { struct ast_binary tree; };
 
+/* isptr(addr) tests whether addr is in a readable region of the target */
+struct ast_isptr {
+    struct ast_unary tree;
+    struct region_table *table;
+};
+
+/* inregion(addr, "path") tests whether addr is in a region with the path */
+struct ast_inregion {
+    struct ast_unary tree;
+    struct region_table *table;
+    char *pattern;
+
+    /* Pattern matches of table regions (computed once per generation) */
+    struct ast_arena *arena;
+    unsigned long generation;
+    unsigned char *matches;
+    size_t matches_size;
+};
+
 /*
- * Routines and macros for allocating & initializing AST nodes.
+ * approx(x, c, eps), ulps(x, c, n) and rounds(x, c, d) test whether a
+ * floating-point x is approximately c (see value_near_bounds()). Bounds of
+ * constant center and tolerance are computed once (`bounded` is nonzero).
  */
-struct ast *ast_value_new(struct value *value);
-struct ast *ast_var_new(struct symbol_table *symtab, size_t sym, size_t size);
+struct ast_near {
+    struct ast_unary tree;
+    struct ast *center, *tolerance;
+    enum value_near mode;
 
-struct ast *ast_cast_new(enum value_type value_type, struct ast *child);
-struct ast *ast_deref_new(struct ast *child, enum value_type value_type,
-                          struct target *target);
+    int bounded;
+    struct value lo, hi;
+};
 
-struct ast *ast_unary_new(enum ast_type node_type, struct ast *child);
-#define ast_neg_new(c)   ast_unary_new(AST_NEG, (c))
-#define ast_not_new(c)   ast_unary_new(AST_NOT, (c))
-#define ast_compl_new(c) ast_unary_new(AST_COMPL, (c))
+/*
+ * within(p, {c1, ..., cN}, r, stride) tests whether N values of the type
+ * `type` at addresses p, p+stride, ... are within Euclidean distance r from
+ * the point (c1, ..., cN). Once the point, r and stride are constant, they
+ * are collected into `center`, `radius2` (r squared, or -1 if r < 0) and
+ * `step`, and the operands are no longer evaluated.
+ */
+struct ast_within {
+    struct ast_unary tree;
+    struct target *target;
+    enum value_type type;
+    struct ast **elements, *radius, *stride;
+    size_t size;
+
+    double *center, radius2;
+    addr_t step;
+};
 
-struct ast *ast_binary_new(enum ast_type node_type,
+/*
+ * bytes(p, "48 8b ?? 4? 89") tests whether `size` bytes at address p match
+ * a pattern, i.e., (byte[i] & mask[i]) == pattern[i] for each i, where the
+ * mask of a wildcard ?? is 0 and of a nibble wildcard (e.g., 4?) is 0xf0.
+ * `anchor` is the index of a byte without wildcards (or `size` if none).
+ */
+#define AST_BYTES_MAX 256
+
+struct ast_bytes {
+    struct ast_unary tree;
+    struct target *target;
+    unsigned char *pattern, *mask;
+    size_t size, anchor;
+};
+
+/*
+ * x in {e1, e2, ...} tests whether x equals any of the elements (which are of
+ * the type of x). Once all elements are constant, their values are collected
+ * into `members` sorted ascending without duplicates (NaNs are dropped), and
+ * the elements are no longer evaluated.
+ */
+#define AST_IN_LINEAR_MAX 8 /* sets scanned linearly instead of bisected */
+
+struct ast_in {
+    struct ast_unary tree;
+    struct ast **elements;
+    size_t size;
+
+    union value_data *members;
+    size_t members_size;
+};
+
+/* Root of an AST with memoized subexpressions (see ast_cse()) */
+struct ast_scope {
+    struct ast_unary tree;
+    unsigned long generation;
+};
+
+/* Subexpression shared by its parents and evaluated once per scope eval */
+struct ast_memo {
+    struct ast_unary tree;
+    struct ast_scope *scope;
+
+    /* Result of the evaluation of the current scope generation */
+    unsigned long generation;
+    int ok;
+    struct value value;
+};
+
+/*
+ * Routines and macros for allocating & initializing AST nodes in an arena.
+ */
+struct ast *ast_value_new(struct ast_arena *a, struct value *value);
+struct ast *ast_var_new(struct ast_arena *a, struct symbol_table *symtab,
+                        size_t sym, size_t size);
+
+struct ast *ast_cast_new(struct ast_arena *a, enum value_type value_type,
+                         struct ast *child);
+struct ast *ast_deref_new(struct ast_arena *a, struct ast *child,
+                          enum value_type value_type, struct target *target);
+
+struct ast *ast_unary_new(struct ast_arena *a, enum ast_type node_type,
+                          struct ast *child);
+#define ast_neg_new(a, c)   ast_unary_new((a), AST_NEG, (c))
+#define ast_not_new(a, c)   ast_unary_new((a), AST_NOT, (c))
+#define ast_compl_new(a, c) ast_unary_new((a), AST_COMPL, (c))
+
+struct ast *ast_binary_new(struct ast_arena *a, enum ast_type node_type,
                            struct ast *left, struct ast *right);
-#define ast_add_new(l, r) ast_binary_new(AST_ADD, (l), (r))
-#define ast_sub_new(l, r) ast_binary_new(AST_SUB, (l), (r))
-#define ast_mul_new(l, r) ast_binary_new(AST_MUL, (l), (r))
-#define ast_div_new(l, r) ast_binary_new(AST_DIV, (l), (r))
-#define ast_and_new(l, r) ast_binary_new(AST_AND, (l), (r))
-#define ast_xor_new(l, r) ast_binary_new(AST_XOR, (l), (r))
-#define ast_or_new(l, r)  ast_binary_new(AST_OR, (l), (r))
-#define ast_shl_new(l, r) ast_binary_new(AST_SHL, (l), (r))
-#define ast_shr_new(l, r) ast_binary_new(AST_SHR, (l), (r))
-
-#define ast_eq_new(l, r)  ast_binary_new(AST_EQ, (l), (r))
-#define ast_neq_new(l, r) ast_binary_new(AST_NEQ, (l), (r))
-#define ast_lt_new(l, r)  ast_binary_new(AST_LT, (l), (r))
-#define ast_gt_new(l, r)  ast_binary_new(AST_GT, (l), (r))
-#define ast_le_new(l, r)  ast_binary_new(AST_LE, (l), (r))
-#define ast_ge_new(l, r)  ast_binary_new(AST_GE, (l), (r))
-
-#define ast_and_cond_new(l, r) ast_binary_new(AST_AND_COND, (l), (r))
-#define ast_or_cond_new(l, r)  ast_binary_new(AST_OR_COND, (l), (r))
+#define ast_add_new(a, l, r) ast_binary_new((a), AST_ADD, (l), (r))
+#define ast_sub_new(a, l, r) ast_binary_new((a), AST_SUB, (l), (r))
+#define ast_mul_new(a, l, r) ast_binary_new((a), AST_MUL, (l), (r))
+#define ast_div_new(a, l, r) ast_binary_new((a), AST_DIV, (l), (r))
+#define ast_and_new(a, l, r) ast_binary_new((a), AST_AND, (l), (r))
+#define ast_xor_new(a, l, r) ast_binary_new((a), AST_XOR, (l), (r))
+#define ast_or_new(a, l, r)  ast_binary_new((a), AST_OR, (l), (r))
+#define ast_shl_new(a, l, r) ast_binary_new((a), AST_SHL, (l), (r))
+#define ast_shr_new(a, l, r) ast_binary_new((a), AST_SHR, (l), (r))
+
+#define ast_eq_new(a, l, r)  ast_binary_new((a), AST_EQ, (l), (r))
+#define ast_neq_new(a, l, r) ast_binary_new((a), AST_NEQ, (l), (r))
+#define ast_lt_new(a, l, r)  ast_binary_new((a), AST_LT, (l), (r))
+#define ast_gt_new(a, l, r)  ast_binary_new((a), AST_GT, (l), (r))
+#define ast_le_new(a, l, r)  ast_binary_new((a), AST_LE, (l), (r))
+#define ast_ge_new(a, l, r)  ast_binary_new((a), AST_GE, (l), (r))
+
+#define ast_and_cond_new(a, l, r) ast_binary_new((a), AST_AND_COND, (l), (r))
+#define ast_or_cond_new(a, l, r)  ast_binary_new((a), AST_OR_COND, (l), (r))
+
+struct ast *ast_isptr_new(struct ast_arena *a, struct ast *child,
+                          struct region_table *table);
+struct ast *ast_inregion_new(struct ast_arena *a, struct ast *child,
+                             struct region_table *table,
+                             const char *pattern, size_t len);
+struct ast *ast_near_new(struct ast_arena *a, struct ast *child,
+                         struct ast *center, struct ast *tolerance,
+                         enum value_near mode);
+struct ast *ast_within_new(struct ast_arena *a, struct ast *child,
+                           struct target *target, enum value_type type,
+                           struct ast **elements, size_t size,
+                           struct ast *radius, struct ast *stride);
+struct ast *ast_bytes_new(struct ast_arena *a, struct ast *child,
+                          struct target *target, const unsigned char *pattern,
+                          const unsigned char *mask, size_t size);
+struct ast *ast_in_new(struct ast_arena *a, struct ast *child,
+                       struct ast **elements, size_t size);
+struct ast *ast_memo_new(struct ast_arena *a, struct ast *child,
+                         struct ast_scope *scope);
+struct ast *ast_scope_new(struct ast_arena *a, struct ast *child);
 
 /*
- * Delete an AST node and its children.
+ * Copy an AST to arena `a`.
+ *
+ * If `bound` is nonzero, variables of symbols numbered `bound` and above are
+ * replaced by constants of their current values (e.g., to bind parameters of
+ * a cached AST). Shared subexpressions are unshared. Returns NULL on error.
  */
-extern void (*ast_delete_funcs[AST_TYPES])(struct ast *);
-#define ast_delete(ast) (ast_delete_funcs[(ast)->node_type]((ast)))
+struct ast *ast_copy(struct ast_arena *a, struct ast *ast, size_t bound);
 
 /*
  * Write a textual representation of an AST node to a string buffer.
@@ -95,36 +95,77 @@ static enum value_type accept_type(const char **pin)
     return 0;
 }
 
+/*
+ * Accept a value type, a comma-separated list of value types (e.g., s32,f32)
+ * or `any` for all signed integer and floating-point types. Returns the
+ * number of distinct types stored to `types` (0 if none accepted).
+ */
+static size_t accept_types(const char **pin, enum value_type *types,
+                           size_t capacity)
+{
+    static const enum value_type any[] = {
+        S8, S16, S32,
+        #ifndef NO_64BIT_VALUES
+        S64,
+        #endif
+        #ifndef NO_FLOAT_VALUES
+        F32, F64
+        #endif
+    };
+    const char *l, *r, *in0 = *pin;
+    size_t i, n;
+
+    if (!eat_item(pin, &l, &r))
+        return 0;
+    if (r - l == 3 && !memcmp(l, "any", 3)) {
+        for (n = 0; n < sizeof(any) / sizeof(*any) && n < capacity; n++)
+            types[n] = any[n];
+        return n;
+    }
+
+    for (n = 0; l < r; l++) {
+        enum value_type type;
+        const char *comma;
+        for (comma = l; comma < r && *comma != ','; comma++);
+        if (!(type = value_type_from_substring(l, comma - l)))
+            break;
+        for (i = 0; i < n && types[i] != type; i++);
+        if (i == n) {
+            if (n == capacity)
+                break;
+            types[n++] = type;
+        }
+        if ((l = comma) == r)
+            return n;
+    }
+    *pin = in0;
+    return 0;
+}
+
+/* Accept a value expression (of its own type if `value_type` is 0) */
 static int accept_value(const char **pin, enum value_type value_type,
                         enum value_type addr_type, int positional,
                         struct value *out)
 {
     const char *start, *in0;
     struct parser parser;
+    struct ast_arena arena;
     parser_init(&parser);
+    ast_arena_init(&arena);
+    parser.arena = &arena;
     start = in0 = *pin;
     if (!positional || eat_item(pin, &start, &parser.end)) {
         struct ast *ast;
         parser.quiet = 1;
         parser.addr_type = addr_type;
         if ((ast = parse_expression(&parser, start))) {
-            struct ast *cast;
-            if (ast->node_type == AST_CAST && (ast->value_type & PTR)) {
-                cast = ast;
+            if (ast->node_type == AST_CAST && (ast->value_type & PTR))
                 ast = ((struct ast_unary *)ast)->child;
-                free(cast);
-            }
-            if (ast->value_type != value_type) {
-                if ((cast = ast_cast_new(value_type, ast))) {
-                    ast = cast;
-                } else {
-                    ast_delete(ast);
-                    ast = NULL;
-                }
-            }
+            if (value_type && ast->value_type != value_type)
+                ast = ast_cast_new(&arena, value_type, ast);
             if (ast) {
                 int ok = ast_evaluate(ast, out);
-                ast_delete(ast);
+                ast_arena_reset(&arena);
                 if (ok) {
                     if (!positional)
                         *pin = parser.in - (parser.symbol->type == LEX_EOL);
@@ -140,6 +181,7 @@ static int accept_value(const char **pin, enum value_type value_type,
                  value_type_to_string(value_type));
         }
     }
+    ast_arena_reset(&arena);
     *pin = in0;
     return 0;
 }
@@ -171,6 +213,45 @@ static int accept_smax(const char **pin, int positional, smax_t *out)
     return 1;
 }
 
+/*
+ * Accept a call '@name arg1 arg2 ...' of an expression prepared with
+ * parameters $1, $2, ... and store the arguments to args[0], args[1], ...
+ * Returns the prepared expression (*pin if not a call) or NULL on error.
+ */
+static const char *accept_prepared(struct ramfuck *ctx, const char **pin,
+                                   const char *who, struct value *args,
+                                   size_t capacity, size_t *args_size)
+{
+    const char *name, *expression;
+    size_t len;
+
+    *args_size = 0;
+    if (**pin != '@')
+        return *pin;
+    name = *pin + 1;
+    for (len = 0; isalnum(name[len]) || name[len] == '_'; len++);
+    if (!(expression = prepared(ctx, name, len))) {
+        errf("%s: no expression prepared as '%.*s'", who, (int)len, name);
+        return NULL;
+    }
+
+    *pin = name + len;
+    skip_spaces(pin);
+    while (!eol(*pin)) {
+        if (*args_size == capacity) {
+            errf("%s: too many arguments for '@%.*s'", who, (int)len, name);
+            return NULL;
+        }
+        if (!accept_value(pin, 0, ctx->addr_type, 1, &args[*args_size])) {
+            errf("%s: invalid argument $%lu for '@%.*s'", who,
+                 (unsigned long)*args_size + 1, (int)len, name);
+            return NULL;
+        }
+        (*args_size)++;
+    }
+    return expression;
+}
+
 static size_t fput_value(struct ramfuck *ctx, const struct value *value,
                          int typed, FILE *stream)
 {
@@ -243,9 +324,9 @@ static int do_0x(struct ramfuck *ctx, const char *in)
  */
 static int do_attach(struct ramfuck *ctx, const char *in)
 {
-    size_t regions, size;
+    size_t i, size;
     struct target *target;
-    struct region *mr;
+    struct region_table *table;
     struct {
         int size;
         char suffix;
@@ -260,6 +341,14 @@ static int do_attach(struct ramfuck *ctx, const char *in)
         errf("attach: attaching to %s failed", in);
         return 2;
     }
+    if (ctx->config->cache.pages) {
+        struct target *cache;
+        if ((cache = target_cache_new(target, ctx->config->cache.pages))) {
+            target = cache;
+        } else {
+            warnf("attach: attaching without a page cache");
+        }
+    }
 
     if (ctx->target) {
         infof("detaching from previous target");
@@ -270,32 +359,29 @@ static int do_attach(struct ramfuck *ctx, const char *in)
         }
         target_detach(ctx->target);
     }
+    compiled_flush(ctx);
     ctx->target = target;
     ctx->breaks = 0;
     ramfuck_break(ctx);
 
-    regions = size = 0;
+    size = 0;
     ctx->addr_type = U32;
-    for (mr = target->region_first(target); mr; mr = target->region_next(mr)) {
-        size += mr->size;
-        regions++;
-        #if ADDR_BITS == 64
-        if (mr->start + mr->size - 1 > UINT32_MAX) {
-            ctx->addr_type = U64;
-            while ((mr = target->region_next(mr))) {
-                size += mr->size;
-                regions++;
-            }
-            break;
+    if ((table = target->regions(target))) {
+        for (i = 0; i < table->size; i++) {
+            const struct region *mr = &table->regions[i];
+            size += mr->size;
+            #if ADDR_BITS == 64
+            if (mr->start + mr->size - 1 > UINT32_MAX)
+                ctx->addr_type = U64;
+            #endif
         }
-        #endif
     }
     ramfuck_continue(ctx);
 
     human_readable_size(size, &human.size, &human.suffix);
-    if (regions > 1) {
+    if (table && table->size > 1) {
         infof("attached to target %s (%d%c / %lu memory regions)",
-              in, human.size, human.suffix, (unsigned long)regions);
+              in, human.size, human.suffix, (unsigned long)table->size);
     } else {
         infof("attached to target %s (%d%c)", in, human.size, human.suffix);
     }
@@ -332,6 +418,35 @@ static int do_break(struct ramfuck *ctx, const char *in)
     return 0;
 }
 
+/*
+ * Show page cache statistics.
+ * Usage: cache
+ */
+static int do_cache(struct ramfuck *ctx, const char *in)
+{
+    size_t size, capacity;
+    unsigned long hits, misses;
+
+    if (!eol(in)) {
+        errf("cache: trailing characters");
+        return 1;
+    }
+
+    if (!ctx->target) {
+        errf("cache: not attached to any target");
+        return 2;
+    }
+
+    if (!target_cache_stats(ctx->target, &size, &capacity, &hits, &misses)) {
+        errf("cache: target has no page cache (see config cache.pages)");
+        return 3;
+    }
+
+    infof("%lu/%lu pages cached, %lu hits, %lu misses",
+          (unsigned long)size, (unsigned long)capacity, hits, misses);
+    return 0;
+}
+
 /*
  * Clear hits.
  * Usage: hits
@@ -409,6 +524,7 @@ static int do_detach(struct ramfuck *ctx, const char *in)
         ctx->breaks = 0;
     }
 
+    compiled_flush(ctx);
     target_detach(ctx->target);
     ctx->target = NULL;
     infof("detached");
@@ -510,7 +626,10 @@ static int do_eval(struct ramfuck *ctx, const char *in)
     int ok;
     struct ast *ast;
     struct parser parser;
+    struct ast_arena arena;
     parser_init(&parser);
+    ast_arena_init(&arena);
+    parser.arena = &arena;
     parser.quiet = 1;
     parser.addr_type = ctx->addr_type;
     parser.target = ctx->target;
@@ -519,12 +638,12 @@ static int do_eval(struct ramfuck *ctx, const char *in)
         if (parser.has_deref) ramfuck_break(ctx);
         ok = ast_evaluate(ast, &out);
         if (parser.has_deref) ramfuck_continue(ctx);
-        ast_delete(ast);
         if (ok) {
             fput_value(ctx, &out, 0, stdout);
             fputc('\n', stdout);
         }
     }
+    ast_arena_reset(&arena);
     return (parser.errors || !ast) ? 1 : (ok ? 0 : 2);
 }
 
@@ -545,10 +664,13 @@ static int do_explain(struct ramfuck *ctx, const char *in)
     /* Isn't it pretty? Like a Down's child */
     if ((symtab = symbol_table_new(ctx))) {
         struct parser parser;
+        struct ast_arena arena;
         struct value value, address;
         struct ast *ast;
 
         parser_init(&parser);
+        ast_arena_init(&arena);
+        parser.arena = &arena;
         value_init_s32(&value, 42);
         symbol_table_add(symtab, "value", S32, &value.data);
 #if ADDR_BITS == 64
@@ -569,8 +691,10 @@ static int do_explain(struct ramfuck *ctx, const char *in)
             printf("rpn: ");
             ast_print(ast);
             printf("\n");
-            if ((ast_opt = ast_optimize(ast))) {
+            /* Optimization is in-place, so optimize a second copy */
+            if ((ast_opt = parse_expression(&parser, in))) {
                 struct value out_opt;
+                ast_opt = ast_optimize(&arena, ast_opt);
                 printf("opt: ");
                 ast_print(ast_opt);
                 printf("\n");
@@ -601,22 +725,21 @@ static int do_explain(struct ramfuck *ctx, const char *in)
                         errf("explain: evaluation of optimized AST failed");
                         rc = 6;
                     }
-                    ast_delete(ast_opt);
                 } else {
                     errf("explain: evaluation of AST failed");
                     rc = 5;
                 }
             } else {
-                errf("explain: optimization of AST faild");
+                errf("explain: reparsing for optimization failed");
                 rc = 4;
             }
             if (parser.has_deref)
                 ramfuck_continue(ctx);
-            ast_delete(ast);
         } else {
             errf("explain: %d parse errors", parser.errors);
             rc = 3;
         }
+        ast_arena_reset(&arena);
         symbol_table_delete(symtab);
     } else {
         errf("explain: creating a symbol table failed");
@@ -629,10 +752,13 @@ static int do_explain(struct ramfuck *ctx, const char *in)
 /*
  * Filter current hits.
  * Usage: filter <expression>
+ *        filter @<prepared> <args>
  */
 static int do_filter(struct ramfuck *ctx, const char *in)
 {
     struct hits *hits;
+    struct value args[16];
+    size_t args_size;
     const char *fmt;
 
     if (eol(in)) {
@@ -645,7 +771,11 @@ static int do_filter(struct ramfuck *ctx, const char *in)
         return 2;
     }
 
-    hits = filter(ctx, ctx->hits, in);
+    if (!(in = accept_prepared(ctx, &in, "filter", args,
+                               sizeof(args) / sizeof(*args), &args_size))) {
+        return 1;
+    }
+    hits = filter(ctx, ctx->hits, in, args, args_size);
     if (hits == ctx->hits)
         return 3;
 
@@ -655,6 +785,130 @@ static int do_filter(struct ramfuck *ctx, const char *in)
     return 0;
 }
 
+/*
+ * Find a pattern of bytes, e.g., `find bytes "48 8b ?? 4? 89"`.
+ * Usage: find bytes <pattern>
+ * where ?? matches any byte and ? in place of a hexadecimal digit matches any
+ * nibble. Hits are the addresses of the first bytes (of type u8).
+ */
+static int do_find(struct ramfuck *ctx, const char *in)
+{
+    static const enum value_type types[] = {U8};
+    char expression[4*AST_BYTES_MAX];
+    struct hits *hits;
+    const char *fmt;
+    size_t len;
+
+    if (!accept(&in, "bytes")) {
+        errf("find: 'bytes' expected");
+        return 1;
+    }
+    if ((len = strlen(in)) && in[0] == '"' && in[len-1] == '"') {
+        in++;
+        len -= 2;
+    }
+    if (!len || len >= sizeof(expression) - 16 || memchr(in, '"', len)) {
+        errf("find: invalid byte pattern");
+        return 1;
+    }
+
+    if (!ctx->target) {
+        errf("find: attach to target first");
+        return 2;
+    }
+
+    sprintf(expression, "bytes(addr, \"%.*s\")", (int)len, in);
+    if (!(hits = search(ctx, types, 1, expression, NULL, 0)))
+        return 3;
+
+    ramfuck_set_hits(ctx, hits);
+    fmt = (ctx->config->cli.base == 16) ? "0x%02"PRIxmax"%s" : "%"PRIumax"%s";
+    printf(fmt, hits->size, ctx->config->cli.quiet ? "\n" : " hits\n");
+    return 0;
+}
+
+/* End of a comma-separated item (outside parentheses, braces and strings) */
+static char *item_end(char *p)
+{
+    int depth = 0, quoted = 0;
+    for (; *p && (depth || quoted || *p != ','); p++) {
+        if (*p == '"') {
+            quoted = !quoted;
+        } else if (!quoted) {
+            depth += (*p == '(' || *p == '{') - (*p == ')' || *p == '}');
+        }
+    }
+    return p;
+}
+
+/*
+ * Search groups of values, e.g., fields of a struct.
+ * Usage: group <offset> <type> <expression>, <offset> <type> <expression>, ...
+ * where `value` of an expression is the field at `offset` bytes from the
+ * base address `addr`. Hits are at the base addresses (of the first type).
+ * For example, `group 0 s32 value == 100, 4 s32 value == 50, 12 s32 value == 7`
+ */
+static int do_group(struct ramfuck *ctx, const char *in)
+{
+    struct search_field fields[16];
+    struct hits *hits;
+    const char *fmt;
+    char *buf, *p;
+    size_t n;
+
+    if (eol(in)) {
+        errf("group: fields expected");
+        return 1;
+    }
+
+    if (!ctx->target) {
+        errf("group: attach to target first");
+        return 2;
+    }
+
+    if (!(buf = malloc(strlen(in) + 1))) {
+        errf("group: out-of-memory for fields");
+        return 3;
+    }
+    strcpy(buf, in);
+    for (n = 0, p = buf; *p; n++) {
+        const char *q = p;
+        char *expr;
+        if (n == sizeof(fields) / sizeof(*fields)) {
+            errf("group: too many fields");
+            free(buf);
+            return 1;
+        }
+        if (!accept_addr(&q, ctx->addr_type, 1, &fields[n].offset)
+                || !(fields[n].type = accept_type(&q))) {
+            errf("group: offset and type of field %lu expected",
+                 (unsigned long)n + 1);
+            free(buf);
+            return 1;
+        }
+        expr = p + (q - p);
+        if ((p = item_end(expr)) == expr) {
+            errf("group: expression of field %lu expected",
+                 (unsigned long)n + 1);
+            free(buf);
+            return 1;
+        }
+        if (*p == ',') *p++ = '\0';
+        while (isspace(*p)) p++;
+        fields[n].expression = expr;
+    }
+
+    hits = search_group(ctx, fields, n);
+    free(buf);
+    if (!hits)
+        return 3;
+
+    ramfuck_set_hits(ctx, hits);
+    fmt = (ctx->config->cli.base == 16) ? "0x%02"PRIxmax"%s" : "%"PRIumax"%s";
+    printf(fmt, hits->size, ctx->config->cli.quiet ? "\n" : " hits\n");
+    return 0;
+}
+
 /*
  * List current hits.
  * Usage: list
@@ -682,13 +936,13 @@ static int do_list(struct ramfuck *ctx, const char *in)
         size_t size;
         struct value value = {0};
         struct hit *hit = &ctx->hits->items[i];
-        value.type = hit->type;
+        value.type = value_type_unswapped(hit->type);
         if (!ctx->config->cli.quiet) {
             fprintf(stdout, "%lu. ", (unsigned long)i + 1);
-            fprintf(stdout, "*(%s *)", value_type_to_string(value.type));
+            fprintf(stdout, "*(%s *)", value_type_to_string(hit->type));
         } else {
             fprintf(stdout, "%lu ", (unsigned long)i + 1);
-            fprintf(stdout, "%s ", value_type_to_string(value.type));
+            fprintf(stdout, "%s ", value_type_to_string(hit->type));
         }
         fprintf(stdout, "0x%08"PRIaddr, hit->addr);
         fputs(ctx->config->cli.quiet ? " " : " = ", stdout);
@@ -698,11 +952,15 @@ static int do_list(struct ramfuck *ctx, const char *in)
         } else if (!target->read(target, hit->addr, &value.data, size)) {
             fprintf(stdout, "??? UNREADABLE");
         } else {
+            if (value_type_is_swapped(hit->type))
+                value_data_swap(&value.data, value_type_sizeof(hit->type));
             fput_value(ctx, &value, 0, stdout);
         }
         if (!ctx->config->cli.quiet) {
             fprintf(stdout, " # prev = ");
             memcpy(&value.data, &hit->prev, size);
+            if (value_type_is_swapped(hit->type))
+                value_data_swap(&value.data, value_type_sizeof(hit->type));
             fput_value(ctx, &value, 0, stdout);
         }
         fputc('\n', stdout);
@@ -719,9 +977,8 @@ static int do_list(struct ramfuck *ctx, const char *in)
 static int do_maps(struct ramfuck *ctx, const char *in)
 {
     char *buf;
-    size_t size;
-    struct target *target;
-    struct region *mr;
+    size_t i, size;
+    struct region_table *table;
 
     if (!eol(in)) {
         errf("maps: trailing characters");
@@ -738,8 +995,14 @@ static int do_maps(struct ramfuck *ctx, const char *in)
         return 3;
     }
 
-    target = ctx->target;
-    for (mr = target->region_first(target); mr; mr = target->region_next(mr)) {
+    if (!(table = ctx->target->regions(ctx->target))) {
+        errf("maps: error reading memory regions of target");
+        free(buf);
+        return 4;
+    }
+
+    for (i = 0; i < table->size; i++) {
+        const struct region *mr = &table->regions[i];
         size_t len = region_snprint(mr, buf, size);
         if (len + 1 > size) {
             char *new = realloc(buf, len + 1);
@@ -813,12 +1076,14 @@ static int do_peek(struct ramfuck *ctx, const char *in)
         fprintf(stdout, "0x%08"PRIaddr" = ", addr);
     }
 
-    out.type = type;
+    out.type = value_type_unswapped(type);
     size = value_type_sizeof((type & PTR) ? ctx->addr_type : type);
     if (!ramfuck_read(ctx, addr, &out.data, size)) {
         fputs("??? UNREADABLE\n", stdout);
         return 5;
     }
+    if (value_type_is_swapped(type))
+        value_data_swap(&out.data, size);
     fput_value(ctx, &out, 0, stdout);
     fputc('\n', stdout);
     return 0;
@@ -831,12 +1096,13 @@ static int do_peek(struct ramfuck *ctx, const char *in)
  */
 static int do_poke(struct ramfuck *ctx, const char *in)
 {
-    enum value_type type;
+    enum value_type type, stored;
     addr_t addr;
     umax_t index;
     smax_t sindex;
     struct parser parser;
-    struct ast *ast, *cast;
+    struct ast_arena arena;
+    struct ast *ast;
     struct value value, address, idx, out;
     size_t size;
     int cont, ok;
@@ -878,7 +1144,13 @@ static int do_poke(struct ramfuck *ctx, const char *in)
         return 4;
     }
 
+    /* Byte-swapped values are computed natively and swapped when stored */
+    stored = type;
+    type = value_type_unswapped(type);
+
     parser_init(&parser);
+    ast_arena_init(&arena);
+    parser.arena = &arena;
     parser.addr_type = ctx->addr_type;
     parser.target = ctx->target;
     if (strstr(in, "addr") || strstr(in, "value") || strstr(in, "idx")) {
@@ -903,16 +1175,17 @@ static int do_poke(struct ramfuck *ctx, const char *in)
 
     if (!(ast = parse_expression(&parser, in))) {
         errf("poke: %d parse errors", parser.errors);
+        ast_arena_reset(&arena);
         symbol_table_delete(parser.symtab);
         return 6;
     }
-    if (!(cast = ast_cast_new((type & PTR) ? parser.addr_type : type, ast))) {
+    ast = ast_cast_new(&arena, (type & PTR) ? parser.addr_type : type, ast);
+    if (!ast) {
         errf("poke: error allocating and initializing typecast AST node");
-        ast_delete(ast);
+        ast_arena_reset(&arena);
         symbol_table_delete(parser.symtab);
         return 6;
     }
-    ast = cast;
 
     size = value_type_sizeof((type & PTR) ? parser.addr_type : type);
     if (parser.symtab && symbol_table_lookup(parser.symtab, "value", 0)) {
@@ -920,33 +1193,39 @@ static int do_poke(struct ramfuck *ctx, const char *in)
         if (!ramfuck_read(ctx, addr, &value.data, size)) {
             errf("poke: error reading %lu bytes from address 0x%08"PRIaddr,
                  (unsigned long)size, addr);
-            ast_delete(ast);
+            ast_arena_reset(&arena);
             symbol_table_delete(parser.symtab);
             ramfuck_continue(ctx);
             return 7;
         }
+        if (value_type_is_swapped(stored))
+            value_data_swap(&value.data, size);
         cont = 1;
     } else if ((cont = parser.has_deref)) {
         ramfuck_break(ctx);
     }
     ok = ast_evaluate(ast, &out);
     if (cont) ramfuck_continue(ctx);
-    ast_delete(ast);
+    ast_arena_reset(&arena);
     symbol_table_delete(parser.symtab);
     if (!ok) {
         errf("poke: evaluating value expression failed");
         return 8;
     }
 
+    if (value_type_is_swapped(stored))
+        value_data_swap(&out.data, size);
     if (!ramfuck_write(ctx, addr, &out.data, size)) {
         errf("poke: error writing %lu bytes to address 0x%08"PRIaddr,
              (unsigned long)size, addr);
         return 9;
     }
+    if (value_type_is_swapped(stored))
+        value_data_swap(&out.data, size);
 
     if (!ctx->config->cli.quiet) {
         if (index > 0) fprintf(stdout, "%"PRIumax". ", index);
-        fprintf(stdout, "*(%s *)", value_type_to_string(type));
+        fprintf(stdout, "*(%s *)", value_type_to_string(stored));
         fprintf(stdout, "0x%08"PRIaddr" = ", addr);
     }
     fput_value(ctx, &out, 0, stdout);
@@ -954,6 +1233,37 @@ static int do_poke(struct ramfuck *ctx, const char *in)
     return 0;
 }
 
+/*
+ * Prepare an expression with parameters $1, $2, ... for search and filter,
+ * or print a prepared expression.
+ * Usage: prepare <name> <expression>
+ *        prepare <name>
+ */
+static int do_prepare(struct ramfuck *ctx, const char *in)
+{
+    const char *name, *expression;
+    size_t len;
+
+    name = in;
+    for (len = 0; isalnum(name[len]) || name[len] == '_'; len++);
+    if (!len || (name[len] && !isspace(name[len]))) {
+        errf("prepare: name expected");
+        return 1;
+    }
+    in += len;
+    skip_spaces(&in);
+
+    if (eol(in)) {
+        if (!(expression = prepared(ctx, name, len))) {
+            errf("prepare: no expression prepared as '%.*s'", (int)len, name);
+            return 2;
+        }
+        printf("%s\n", expression);
+        return 0;
+    }
+    return prepare(ctx, name, len, in) ? 0 : 3;
+}
+
 /*
  * Quit ramfuck.
  * Usage: quit
@@ -972,6 +1282,7 @@ static int do_quit(struct ramfuck *ctx, const char *in) {
                 warnf("quit: continuing execution of target");
             ctx->breaks = 0;
         }
+        compiled_flush(ctx);
         target_detach(ctx->target);
         ctx->target = NULL;
     }
@@ -1096,13 +1407,20 @@ static int do_redo(struct ramfuck *ctx, const char *in)
 /*
  * Initial search.
  * Usage: search <expression>
- *        search <type> <expression>
- * where 'type' is one of: s8, u8, s16, u16, s32, u32, s64, u64, f32, f64.
+ *        search <types> <expression>
+ *        search <types> @<prepared> <args>
+ * where 'types' is one of: s8, u8, s16, u16, s32, u32, s64, u64, f32, f64,
+ * be16, be32, be64 (big-endian signed integers), a comma-separated list of
+ * them (e.g., s32,f32) or 'any' for s8, s16, s32, s64, f32 and f64. Memory
+ * is read once for all types, and the hits are of mixed types.
  */
 static int do_search(struct ramfuck *ctx, const char *in)
 {
-    enum value_type type;
+    enum value_type types[16];
+    size_t types_size;
     struct hits *hits;
+    struct value args[16];
+    size_t args_size;
     const char *fmt;
 
     if (eol(in)) {
@@ -1115,10 +1433,17 @@ static int do_search(struct ramfuck *ctx, const char *in)
         return 2;
     }
 
-    if (!(type = accept_type(&in)))
-        type = S32;
+    if (!(types_size = accept_types(&in, types,
+                                    sizeof(types) / sizeof(*types)))) {
+        types[0] = S32;
+        types_size = 1;
+    }
 
-    hits = search(ctx, type, in);
+    if (!(in = accept_prepared(ctx, &in, "search", args,
+                               sizeof(args) / sizeof(*args), &args_size))) {
+        return 1;
+    }
+    hits = search(ctx, types, types_size, in, args, args_size);
     if (!hits)
         return 3;
 
@@ -1272,6 +1597,8 @@ int cli_execute_line(struct ramfuck *ctx, const char *in)
         rc = do_attach(ctx, in);
     } else if (accept(&in, "break")) {
         rc = do_break(ctx, in);
+    } else if (accept(&in, "cache")) {
+        rc = do_cache(ctx, in);
     } else if (accept(&in, "clear")) {
         rc = do_clear(ctx, in);
     } else if (accept(&in, "config")) {
@@ -1280,6 +1607,10 @@ int cli_execute_line(struct ramfuck *ctx, const char *in)
         rc = do_continue(ctx, in);
     } else if (accept(&in, "detach")) {
         rc = do_detach(ctx, in);
+    } else if (accept(&in, "find")) {
+        rc = do_find(ctx, in);
+    } else if (accept(&in, "group")) {
+        rc = do_group(ctx, in);
     } else if (accept(&in, "hex")) {
         rc = do_hex(ctx, in);
     } else if (accept(&in, "explain")) {
@@ -1296,6 +1627,8 @@ int cli_execute_line(struct ramfuck *ctx, const char *in)
         rc = do_peek(ctx, in);
     } else if (accept(&in, "poke")) {
         rc = do_poke(ctx, in);
+    } else if (accept(&in, "prepare")) {
+        rc = do_prepare(ctx, in);
     } else if (accept(&in, "quit") || accept(&in, "q") || accept(&in, "exit")) {
         rc = do_quit(ctx, in);
     } else if (accept(&in, "read")) {
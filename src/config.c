@@ -29,11 +29,16 @@ struct config *config_new()
     struct config *cfg;
     if ((cfg = malloc(sizeof(struct config)))) {
         cfg->block.size = 256;
+        cfg->cache.pages = 0;
         cfg->cli.base = 10;
         cfg->cli.quiet = 0;
         cfg->search.align = 0;
         cfg->search.prot = 6; /* MEM_READ | MEM_WRITE */
         cfg->search.progress = 1;
+        cfg->search.nonstop = 0;
+        cfg->search.snapshot = 0;
+        cfg->search.swapped = 0;
+        cfg->search.dedup = 0;
     }
     return cfg;
 }
@@ -50,11 +55,16 @@ int config_process_line(struct config *cfg, const char *in)
         if (quiet)
             cfg->cli.quiet = 0;
         config_process_line(cfg, "block.size");
+        config_process_line(cfg, "cache.pages");
         config_process_line(cfg, "cli.base");
         fprintf(stdout, "cli.quiet = %d\n", quiet);
         config_process_line(cfg, "search.align");
         config_process_line(cfg, "search.prot");
         config_process_line(cfg, "search.progress");
+        config_process_line(cfg, "search.nonstop");
+        config_process_line(cfg, "search.snapshot");
+        config_process_line(cfg, "search.swapped");
+        config_process_line(cfg, "search.dedup");
         if (quiet)
             cfg->cli.quiet = 1;
         return 1;
@@ -76,6 +86,22 @@ int config_process_line(struct config *cfg, const char *in)
         if (!cfg->cli.quiet)
             fputs("block.size = ", stdout);
         fprintf(stdout, "%lu", cfg->block.size);
+    } else if (accept(&in, "cache.pages")) {
+        if (!eol(in)) {
+            char *end;
+            long value = strtol(in, &end, 0);
+            while (isspace(*end)) end++;
+            if (*end || value < 0) {
+                errf("config: bad cache.pages value");
+                return 0;
+            }
+            cfg->cache.pages = value;
+            if (cfg->cli.quiet)
+                return 1;
+        }
+        if (!cfg->cli.quiet)
+            fputs("cache.pages = ", stdout);
+        fprintf(stdout, "%lu", cfg->cache.pages);
     } else if (accept(&in, "cli.base")) {
         if (!eol(in)) {
             char *end;
@@ -162,6 +188,74 @@ int config_process_line(struct config *cfg, const char *in)
         if (!cfg->cli.quiet)
             fputs("search.progress = ", stdout);
         fprintf(stdout, "%d", cfg->search.progress);
+    } else if (accept(&in, "search.nonstop")) {
+        if (!eol(in)) {
+            int nonstop = accept(&in, "1");
+            if (!nonstop && accept(&in, "0") && eol(in)) {
+                cfg->search.nonstop = 0;
+            } else if (nonstop && eol(in)) {
+                cfg->search.nonstop = 1;
+            } else {
+                errf("config: bad search.nonstop value (expected 0 or 1)");
+                return 0;
+            }
+            if (cfg->cli.quiet)
+                return 1;
+        }
+        if (!cfg->cli.quiet)
+            fputs("search.nonstop = ", stdout);
+        fprintf(stdout, "%d", cfg->search.nonstop);
+    } else if (accept(&in, "search.snapshot")) {
+        if (!eol(in)) {
+            int snapshot = accept(&in, "1");
+            if (!snapshot && accept(&in, "0") && eol(in)) {
+                cfg->search.snapshot = 0;
+            } else if (snapshot && eol(in)) {
+                cfg->search.snapshot = 1;
+            } else {
+                errf("config: bad search.snapshot value (expected 0 or 1)");
+                return 0;
+            }
+            if (cfg->cli.quiet)
+                return 1;
+        }
+        if (!cfg->cli.quiet)
+            fputs("search.snapshot = ", stdout);
+        fprintf(stdout, "%d", cfg->search.snapshot);
+    } else if (accept(&in, "search.swapped")) {
+        if (!eol(in)) {
+            int swapped = accept(&in, "1");
+            if (!swapped && accept(&in, "0") && eol(in)) {
+                cfg->search.swapped = 0;
+            } else if (swapped && eol(in)) {
+                cfg->search.swapped = 1;
+            } else {
+                errf("config: bad search.swapped value (expected 0 or 1)");
+                return 0;
+            }
+            if (cfg->cli.quiet)
+                return 1;
+        }
+        if (!cfg->cli.quiet)
+            fputs("search.swapped = ", stdout);
+        fprintf(stdout, "%d", cfg->search.swapped);
+    } else if (accept(&in, "search.dedup")) {
+        if (!eol(in)) {
+            int dedup = accept(&in, "1");
+            if (!dedup && accept(&in, "0") && eol(in)) {
+                cfg->search.dedup = 0;
+            } else if (dedup && eol(in)) {
+                cfg->search.dedup = 1;
+            } else {
+                errf("config: bad search.dedup value (expected 0 or 1)");
+                return 0;
+            }
+            if (cfg->cli.quiet)
+                return 1;
+        }
+        if (!cfg->cli.quiet)
+            fputs("search.dedup = ", stdout);
+        fprintf(stdout, "%d", cfg->search.dedup);
     } else {
         size_t i;
         for (i = 0; in[i] && in[i] != '=' && !isspace(in[i]); i++);
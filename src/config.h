@@ -9,6 +9,14 @@ struct config {
         unsigned long size;
     } block;
 
+    struct {
+        /*
+         * Number of pages in the LRU page cache of a target attached next.
+         * 0 -> No page cache
+         */
+        unsigned long pages;
+    } cache;
+
     struct {
         /*
          * Default base for displaying numbers in CLI.
@@ -48,6 +56,34 @@ struct config {
          * 2 -> Output scanned memory regions
          */
         int progress;
+
+        /*
+         * Non-stop scanning.
+         * 0 -> Stop target for the whole duration of a search
+         * 1 -> Scan running target and stop it only to re-verify the hits
+         */
+        int nonstop;
+
+        /*
+         * Snapshot scanning.
+         * 0 -> Scan the target itself
+         * 1 -> Scan a forked copy-on-write snapshot of the target (if able)
+         */
+        int snapshot;
+
+        /*
+         * Swapped out pages.
+         * 0 -> Skip pages swapped out of the target
+         * 1 -> Scan swapped pages as well (reading swaps them back in)
+         */
+        int swapped;
+
+        /*
+         * Page deduplication.
+         * 0 -> Evaluate the expression for every page
+         * 1 -> Reuse hits of pages with identical contents
+         */
+        int dedup;
     } search;
 };
 
@@ -2,6 +2,7 @@
 #include "symbol.h"
 #include "target.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 static int ast_value_evaluate(struct ast *this, struct value *out)
@@ -245,6 +246,270 @@ static int ast_or_cond_evaluate(struct ast *this, struct value *out)
     return 1;
 }
 
+static int ast_isptr_evaluate(struct ast *this, struct value *out)
+{
+    struct value value;
+    if (ast_evaluate(((struct ast_unary *)this)->child, &value)) {
+        const struct region *region;
+        struct region_table *table = ((struct ast_isptr *)this)->table;
+#if ADDR_BITS == 64
+        addr_t addr = (value.type == U64) ? value.data.u64 : value.data.u32;
+#else
+        addr_t addr = value.data.u32;
+#endif
+        region = region_table_find(table, addr);
+        return value_init_s32(out, region && (region->prot & MEM_READ));
+    }
+    return 0;
+}
+
+static int ast_inregion_evaluate(struct ast *this, struct value *out)
+{
+    struct value value;
+    struct ast_inregion *inregion = (struct ast_inregion *)this;
+    struct region_table *table = inregion->table;
+    if (inregion->generation != table->generation || !inregion->matches) {
+        size_t i;
+        unsigned char *matches = inregion->matches;
+        if (inregion->matches_size < table->size + 1) {
+            matches = ast_arena_alloc(inregion->arena, table->size + 1);
+            if (!matches)
+                return 0;
+            inregion->matches_size = table->size + 1;
+        }
+        for (i = 0; i < table->size; i++) {
+            const char *path = table->regions[i].path;
+            matches[i] = path && strstr(path, inregion->pattern);
+        }
+        inregion->matches = matches;
+        inregion->generation = table->generation;
+    }
+
+    if (ast_evaluate(((struct ast_unary *)this)->child, &value)) {
+        const struct region *region;
+#if ADDR_BITS == 64
+        addr_t addr = (value.type == U64) ? value.data.u64 : value.data.u32;
+#else
+        addr_t addr = value.data.u32;
+#endif
+        if (!(region = region_table_find(table, addr)))
+            return value_init_s32(out, 0);
+        return value_init_s32(out, inregion->matches[region - table->regions]);
+    }
+    return 0;
+}
+
+static int ast_near_evaluate(struct ast *this, struct value *out)
+{
+#ifndef NO_FLOAT_VALUES
+    struct ast_near *near = (struct ast_near *)this;
+    struct value x, center, tolerance, lo, hi;
+
+    if (!ast_evaluate(near->tree.child, &x))
+        return 0;
+    if (near->bounded) {
+        lo = near->lo;
+        hi = near->hi;
+    } else if (!ast_evaluate(near->center, &center)
+               || !ast_evaluate(near->tolerance, &tolerance)
+               || !value_near_bounds(near->mode, x.type, &center, &tolerance,
+                                     &lo, &hi)) {
+        return 0;
+    }
+
+    /* Compare as f64 (which represents all f32 values exactly) */
+    if (!value_ops(&x)->cast_to_f64(&x, &x)
+            || !value_ops(&lo)->cast_to_f64(&lo, &lo)
+            || !value_ops(&hi)->cast_to_f64(&hi, &hi)) {
+        return 0;
+    }
+    return value_init_s32(out, lo.data.f64 <= x.data.f64
+                               && x.data.f64 <= hi.data.f64);
+#else
+    return 0;
+#endif
+}
+
+static int ast_within_evaluate(struct ast *this, struct value *out)
+{
+#ifndef NO_FLOAT_VALUES
+    struct ast_within *within = (struct ast_within *)this;
+    struct value value, c;
+    double d2, radius2;
+    addr_t addr, step;
+    size_t i;
+
+    if (!ast_evaluate(within->tree.child, &value))
+        return 0;
+#if ADDR_BITS == 64
+    addr = (value.type == U64) ? value.data.u64 : value.data.u32;
+#else
+    addr = value.data.u32;
+#endif
+    if (within->center) {
+        radius2 = within->radius2;
+        step = within->step;
+    } else if (ast_evaluate(within->radius, &c)
+               && value_ops(&c)->cast_to_f64(&c, &c)) {
+        radius2 = (c.data.f64 < 0) ? -1 : c.data.f64 * c.data.f64;
+        if (!ast_evaluate(within->stride, &value)
+                || !value_type_ops(UMAX)->assign(&c, &value)) {
+            return 0;
+        }
+        step = (addr_t)c.data.umax;
+    } else {
+        return 0;
+    }
+
+    for (i = 0, d2 = 0; i < within->size; i++) {
+        double d;
+        value.type = within->type;
+        if (!within->target->read(within->target, addr + i*step,
+                                  &value.data, value_sizeof(&value))
+                || !value_ops(&value)->cast_to_f64(&value, &value)) {
+            return 0;
+        }
+        if (within->center) {
+            d = value.data.f64 - within->center[i];
+        } else if (ast_evaluate(within->elements[i], &c)
+                   && value_ops(&c)->cast_to_f64(&c, &c)) {
+            d = value.data.f64 - c.data.f64;
+        } else {
+            return 0;
+        }
+        if ((d2 += d*d) > radius2)
+            break;
+    }
+    return value_init_s32(out, d2 <= radius2);
+#else
+    return 0;
+#endif
+}
+
+static int ast_bytes_evaluate(struct ast *this, struct value *out)
+{
+    struct ast_bytes *bytes = (struct ast_bytes *)this;
+    unsigned char data[AST_BYTES_MAX];
+    struct value value;
+    addr_t addr;
+    size_t i;
+
+    if (!ast_evaluate(bytes->tree.child, &value))
+        return 0;
+#if ADDR_BITS == 64
+    addr = (value.type == U64) ? value.data.u64 : value.data.u32;
+#else
+    addr = value.data.u32;
+#endif
+    if (!bytes->target->read(bytes->target, addr, data, bytes->size))
+        return 0;
+    for (i = 0; i < bytes->size; i++) {
+        if ((data[i] & bytes->mask[i]) != bytes->pattern[i])
+            break;
+    }
+    return value_init_s32(out, i == bytes->size);
+}
+
+/*
+ * Membership tests of sorted set members. Small sets are scanned without
+ * branching on each member, larger ones are bisected.
+ */
+#define AST_IN_MEMBER(field)                                                \
+static int ast_in_member_##field(const union value_data *set, size_t n,     \
+                                 const union value_data *x)                 \
+{                                                                           \
+    size_t i, lo, hi;                                                       \
+    if (n <= AST_IN_LINEAR_MAX) {                                           \
+        int hit = 0;                                                        \
+        for (i = 0; i < n; i++)                                             \
+            hit |= set[i].field == x->field;                                \
+        return hit;                                                         \
+    }                                                                       \
+    for (lo = 0, hi = n; lo < hi; ) {                                       \
+        i = lo + (hi - lo) / 2;                                             \
+        if (set[i].field < x->field) {                                      \
+            lo = i + 1;                                                     \
+        } else {                                                            \
+            hi = i;                                                         \
+        }                                                                   \
+    }                                                                       \
+    return lo < n && set[lo].field == x->field;                             \
+}
+
+AST_IN_MEMBER(s8)
+AST_IN_MEMBER(u8)
+AST_IN_MEMBER(s16)
+AST_IN_MEMBER(u16)
+AST_IN_MEMBER(s32)
+AST_IN_MEMBER(u32)
+#ifndef NO_64BIT_VALUES
+AST_IN_MEMBER(s64)
+AST_IN_MEMBER(u64)
+#endif
+#ifndef NO_FLOAT_VALUES
+AST_IN_MEMBER(f32)
+AST_IN_MEMBER(f64)
+#endif
+
+static int (*const ast_in_members[VALUE_TYPES])(const union value_data *,
+                                                size_t,
+                                                const union value_data *) = {
+    ast_in_member_s8, ast_in_member_u8,
+    ast_in_member_s16, ast_in_member_u16,
+    ast_in_member_s32, ast_in_member_u32,
+    #ifndef NO_64BIT_VALUES
+    ast_in_member_s64, ast_in_member_u64,
+    #endif
+    #ifndef NO_FLOAT_VALUES
+    ast_in_member_f32, ast_in_member_f64,
+    #endif
+};
+
+static int ast_in_evaluate(struct ast *this, struct value *out)
+{
+    struct ast_in *in = (struct ast_in *)this;
+    struct value value, element, eq;
+    size_t i;
+
+    if (!ast_evaluate(in->tree.child, &value))
+        return 0;
+    if (in->members) {
+        int hit = ast_in_members[value_index(&value)](in->members,
+                                                      in->members_size,
+                                                      &value.data);
+        return value_init_s32(out, hit);
+    }
+
+    for (i = 0; i < in->size; i++) {
+        if (!ast_evaluate(in->elements[i], &element)
+                || !value_ops(&value)->eq(&value, &element, &eq)) {
+            return 0;
+        }
+        if (value_is_nonzero(&eq))
+            return value_init_s32(out, 1);
+    }
+    return value_init_s32(out, 0);
+}
+
+static int ast_memo_evaluate(struct ast *this, struct value *out)
+{
+    struct ast_memo *memo = (struct ast_memo *)this;
+    if (memo->generation != memo->scope->generation) {
+        struct ast *child = ((struct ast_unary *)this)->child;
+        memo->ok = ast_evaluate(child, &memo->value);
+        memo->generation = memo->scope->generation;
+    }
+    if (memo->ok)
+        *out = memo->value;
+    return memo->ok;
+}
+
+static int ast_scope_evaluate(struct ast *this, struct value *out)
+{
+    ((struct ast_scope *)this)->generation++;
+    return ast_evaluate(((struct ast_unary *)this)->child, out);
+}
+
 int (*ast_evaluate_funcs[AST_TYPES])(struct ast *, struct value *) = {
     /* AST_VALUE */ ast_value_evaluate,
     /* AST_VAR   */ ast_var_evaluate,
@@ -262,8 +527,8 @@ int (*ast_evaluate_funcs[AST_TYPES])(struct ast *, struct value *) = {
     /* AST_MOD */ ast_mod_evaluate,
 
     /* AST_AND */ ast_and_evaluate,
-    /* AST_OR  */ ast_or_evaluate,
     /* AST_XOR */ ast_xor_evaluate,
+    /* AST_OR  */ ast_or_evaluate,
     /* AST_SHL */ ast_shl_evaluate,
     /* AST_SHR */ ast_shr_evaluate,
 
@@ -275,5 +540,16 @@ int (*ast_evaluate_funcs[AST_TYPES])(struct ast *, struct value *) = {
     /* AST_GE  */ ast_ge_evaluate,
 
     /* AST_AND_COND */ ast_and_cond_evaluate,
-    /* AST_OR_COND  */ ast_or_cond_evaluate
+    /* AST_OR_COND  */ ast_or_cond_evaluate,
+
+    /* AST_ISPTR    */ ast_isptr_evaluate,
+    /* AST_INREGION */ ast_inregion_evaluate,
+    /* AST_NEAR     */ ast_near_evaluate,
+    /* AST_WITHIN   */ ast_within_evaluate,
+    /* AST_BYTES    */ ast_bytes_evaluate,
+
+    /* AST_IN */ ast_in_evaluate,
+
+    /* AST_MEMO  */ ast_memo_evaluate,
+    /* AST_SCOPE */ ast_scope_evaluate
 };
@@ -49,3 +49,16 @@ int hits_add(struct hits *hits, addr_t addr, enum value_type type,
     memcpy(&hit->prev, data, size);
     return 1;
 }
+
+static int hit_compare(const void *a, const void *b)
+{
+    const struct hit *x = a, *y = b;
+    if (x->addr != y->addr)
+        return (x->addr > y->addr) - (x->addr < y->addr);
+    return (x->type > y->type) - (x->type < y->type);
+}
+
+void hits_sort(struct hits *hits)
+{
+    qsort(hits->items, (size_t)hits->size, sizeof(struct hit), hit_compare);
+}
@@ -18,7 +18,7 @@ struct hits {
     struct hit *items;
     umax_t size, capacity;
     enum value_type addr_type;
-    enum value_type value_type;
+    enum value_type value_type; /* type of all hits (0 if types are mixed) */
 };
 
 /*
@@ -32,4 +32,9 @@ void hits_delete(struct hits *hits);
  */
 int hits_add(struct hits *hits, addr_t addr, enum value_type type,
              union value_data *data);
+
+/*
+ * Sort hits by address (and hits of the same address by type).
+ */
+void hits_sort(struct hits *hits);
 #endif
@@ -242,6 +242,32 @@ int lexer(const char **pin, struct lex_token *out)
     switch (get(pin)) {
     case '(': out->type = LEX_LEFT_PARENTHESIS; break;
     case ')': out->type = LEX_RIGHT_PARENTHESIS; break;
+    case ',': out->type = LEX_COMMA; break;
+    case '{': out->type = LEX_LEFT_BRACE; break;
+    case '}': out->type = LEX_RIGHT_BRACE; break;
+
+    case '"':
+        out->value.string.str = *pin;
+        while (peek(pin) && peek(pin) != '"' && peek(pin) != '\n')
+            (*pin)++;
+        if (!accept(pin, '"')) {
+            errf("lex: unterminated string literal");
+            return 0;
+        }
+        out->value.string.len = *pin - out->value.string.str - 1;
+        out->type = LEX_STRING;
+        break;
+
+    case '$':
+        out->value.identifier.name = *pin - 1;
+        if (!acceptf(pin, isdigit)) {
+            errf("lex: expected parameter number after '$'");
+            return 0;
+        }
+        while (acceptf(pin, isdigit));
+        out->value.identifier.len = *pin - out->value.identifier.name;
+        out->type = LEX_PARAMETER;
+        break;
 
     case '.':
     case '0': case '1': case '2': case '3': case '4':
@@ -328,6 +354,9 @@ const char *lex_token_type_string[LEX_TYPES] = {
     "EOL",  /* LEX_EOL */
     "(",    /* LEX_LEFT_PARENTHESIS */
     ")",    /* LEX_RIGHT_PARENTHESIS */
+    ",",    /* LEX_COMMA */
+    "{",    /* LEX_LEFT_BRACE */
+    "}",    /* LEX_RIGHT_BRACE */
 
     "sint", /* LEX_INTEGER */
     "uint", /* LEX_UINTEGER */
@@ -335,6 +364,8 @@ const char *lex_token_type_string[LEX_TYPES] = {
     "fp",   /* LEX_FLOATING_POINT */
 #endif
     "var",  /* LEX_IDENTIFIER */
+    "str",  /* LEX_STRING */
+    "$",    /* LEX_PARAMETER */
 
     "(T)",  /* LEX_CAST */
     "u*",   /* LEX_DEREF */
@@ -376,11 +407,17 @@ size_t lex_token_to_string(struct lex_token *t, char *out, size_t size)
     case LEX_FLOATING_POINT:
         return snprintf(out, size, "%g", t->value.fp);
 #endif
-    case LEX_IDENTIFIER: {
+    case LEX_IDENTIFIER:
+    case LEX_PARAMETER: {
         const char *name = t->value.identifier.name;
         size_t len = t->value.identifier.len;
         return snprintf(out, size, "%.*s", (int)len, name);
     }
+    case LEX_STRING: {
+        const char *str = t->value.string.str;
+        size_t len = t->value.string.len;
+        return snprintf(out, size, "\"%.*s\"", (int)len, str);
+    }
 
     default:
         if (t->type >= 0 && t->type < LEX_TYPES)
@@ -9,13 +9,14 @@
 enum lex_token_type {
     LEX_NIL = 0,
 
-    LEX_EOL, LEX_LEFT_PARENTHESIS, LEX_RIGHT_PARENTHESIS,
+    LEX_EOL, LEX_LEFT_PARENTHESIS, LEX_RIGHT_PARENTHESIS, LEX_COMMA,
+    LEX_LEFT_BRACE, LEX_RIGHT_BRACE,
 
     LEX_INTEGER, LEX_UINTEGER,
     #ifndef NO_FLOAT_VALUES
     LEX_FLOATING_POINT,
     #endif
-    LEX_IDENTIFIER,
+    LEX_IDENTIFIER, LEX_STRING, LEX_PARAMETER,
 
     /* The order must match ast_types in ast.h */
     LEX_CAST, LEX_DEREF, LEX_NEG, /* reserved */
@@ -40,13 +41,17 @@ struct lex_token {
         #ifndef NO_FLOAT_VALUES
         double fp;
         #endif
+        /* Identifier or parameter ($ followed by decimal digits) */
         struct {
             const char *name;
             size_t len;
         } identifier;
 
-        /*char string[4096];
-        wchar_t wstring[2048];*/ /* Not supported (yet?) */
+        /* String literal without the quotes (escapes are not supported) */
+        struct {
+            const char *str;
+            size_t len;
+        } string;
     } value;
 };
 
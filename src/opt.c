@@ -1,79 +1,780 @@
 #include "opt.h"
 #include "eval.h"
 
-static struct ast *ast_var_optimize(struct ast *this)
+#include <stdlib.h>
+#include <string.h>
+
+static struct ast *ast_leaf_optimize(struct ast_arena *a, struct ast *this)
 {
-    struct ast_var *var = (struct ast_var *)this;
-    struct ast *opt = ast_var_new(var->symtab, var->sym, var->size);
-    if (opt) opt->value_type = this->value_type;
-    return opt;
+    return this;
 }
 
-static struct ast *ast_value_optimize(struct ast *this)
+/* Replace a node with constant operands by its value */
+static struct ast *ast_fold(struct ast_arena *a, struct ast *this)
 {
+    struct value value;
     struct ast *ast;
-    if ((ast = ast_value_new(&((struct ast_value *)this)->value)))
-        ast->value_type = this->value_type;
-    return ast;
+    if (ast_evaluate(this, &value) && (ast = ast_value_new(a, &value)))
+        return ast;
+    return this;
+}
+
+static struct ast *ast_unary_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_unary *unary = (struct ast_unary *)this;
+    unary->child = ast_optimize(a, unary->child);
+    return ast_is_constant(unary->child) ? ast_fold(a, this) : this;
+}
+
+/*
+ * Algebraic normalization of comparisons.
+ *
+ * Comparisons are canonicalized to have constants on the right, and integer
+ * (in)equalities `x OP c` are solved for x when OP is bijective modulo 2^n,
+ * e.g., `value - 5 == 10` becomes `value == 15`. Nodes replaced by the
+ * rewrites are abandoned to the arena.
+ */
+#define ast_value_of(ast) (&((struct ast_value *)(ast))->value)
+#define value_type_is_signed(t) (!(value_type_index(t) & 1))
+#define value_type_unsigned(t) ((t) | 0x00010000)
+
+static umax_t value_to_umax(struct value *value)
+{
+    struct value out;
+    value_type_ops(UMAX)->assign(&out, value);
+    return out.data.umax;
+}
+
+static void value_from_umax(struct value *out, enum value_type type, umax_t x)
+{
+    struct value value;
+    value_init_umax(&value, x);
+    value_type_ops(type)->assign(out, &value);
+}
+
+/* Multiplicative inverse of an odd integer modulo 2^n (Newton's method) */
+static umax_t umax_inverse(umax_t k)
+{
+    int i;
+    umax_t inv = k;
+    for (i = 0; i < 5; i++)
+        inv *= 2 - k * inv;
+    return inv;
+}
+
+static enum ast_type compare_mirror(enum ast_type type)
+{
+    switch (type) {
+    case AST_LT: return AST_GT;
+    case AST_GT: return AST_LT;
+    case AST_LE: return AST_GE;
+    case AST_GE: return AST_LE;
+    default: return type;
+    }
+}
+
+/* Check that multiplying `x` by `k` cannot overflow the type of x */
+static int ast_mul_is_exact(struct ast *x, struct value *k)
+{
+    umax_t n = value_to_umax(k);
+    size_t bits, type_bits = value_type_sizeof(x->value_type) * 8;
+    struct ast *child = ((struct ast_unary *)x)->child;
+    if (x->node_type != AST_CAST || (x->value_type & PTR)
+            || !value_type_is_int(child->value_type)
+            || (child->value_type & PTR)) {
+        return 0;
+    }
+    if (value_type_is_signed(k->type) && (smax_t)n < 0)
+        n = -n;
+    for (bits = value_type_sizeof(child->value_type) * 8 + 1; n; n >>= 1)
+        bits++;
+    return bits <= type_bits;
 }
 
-static struct ast *ast_unary_optimize(struct ast *this)
+/*
+ * Solve `x OP c` of an integer (in)equality for an operand of x. Returns 0 if
+ * nothing was solved, or if the comparison turned out to be constant (which
+ * replaces `*pthis` with a constant).
+ */
+static int ast_compare_solve(struct ast_arena *a, struct ast **pthis)
 {
-    struct ast *child = ast_optimize(((struct ast_unary *)this)->child);
-    struct ast *ast = ast_unary_new(this->node_type, child);
-    if (ast) {
-        ast->value_type = this->value_type;
-        if (ast_is_constant(child)) {
-            struct value value;
-            if (ast_evaluate(ast, &value)) {
-                ast_delete(ast);
-                ast = ast_value_new(&value);
+    struct ast *this = *pthis;
+    struct ast_binary *cmp = (struct ast_binary *)this;
+    struct value *c = ast_value_of(cmp->right);
+    const struct value_operations *ops = value_type_ops(c->type);
+    struct ast *x = cmp->left, *operand, *konst;
+    struct value k, out;
+
+    if (x->value_type != c->type)
+        return 0;
+
+    if (x->node_type == AST_NEG || x->node_type == AST_COMPL) {
+        operand = ((struct ast_unary *)x)->child;
+        if (operand->value_type != c->type)
+            return 0;
+        if (!(x->node_type == AST_NEG ? ops->neg(c, &out)
+                                      : ops->compl(c, &out))) {
+            return 0;
+        }
+        *c = out;
+        cmp->left = operand;
+        return 1;
+    }
+
+    if (x->node_type != AST_ADD && x->node_type != AST_SUB
+            && x->node_type != AST_XOR && x->node_type != AST_MUL) {
+        return 0;
+    }
+    if (ast_is_constant(((struct ast_binary *)x)->right)) {
+        konst = ((struct ast_binary *)x)->right;
+        operand = ((struct ast_binary *)x)->left;
+    } else if (ast_is_constant(((struct ast_binary *)x)->left)) {
+        konst = ((struct ast_binary *)x)->left;
+        operand = ((struct ast_binary *)x)->right;
+    } else {
+        return 0;
+    }
+    if (operand->value_type != c->type || konst->value_type != c->type)
+        return 0;
+    k = *ast_value_of(konst);
+
+    switch (x->node_type) {
+    case AST_ADD:
+        if (!ops->sub(c, &k, &out)) return 0;
+        break;
+    case AST_SUB:
+        if (konst == ((struct ast_binary *)x)->right) {
+            if (!ops->add(c, &k, &out)) return 0;
+        } else if (!ops->sub(&k, c, &out)) {
+            return 0;
+        }
+        break;
+    case AST_XOR:
+        if (!ops->xor(c, &k, &out)) return 0;
+        break;
+    default: /* AST_MUL */
+        if (value_to_umax(&k) & 1) {
+            umax_t inverse = umax_inverse(value_to_umax(&k));
+            value_from_umax(&out, c->type, value_to_umax(c) * inverse);
+        } else if (value_to_umax(&k) && ast_mul_is_exact(operand, &k)) {
+            struct value rem;
+            if (!ops->mod(c, &k, &rem))
+                return 0;
+            if (value_is_nonzero(&rem)) {
+                /* No solution, so the comparison is constant */
+                struct ast *ast;
+                value_from_umax(&out, this->value_type,
+                                this->node_type == AST_NEQ);
+                if ((ast = ast_value_new(a, &out)))
+                    *pthis = ast;
+                return 0;
             }
+            if (!ops->div(c, &k, &out))
+                return 0;
+        } else {
+            return 0;
         }
+        break;
     }
-    return ast;
+
+    *c = out;
+    cmp->left = operand;
+    return 1;
 }
 
-static struct ast *ast_binary_optimize(struct ast *this)
+static struct ast *ast_compare_normalize(struct ast_arena *a, struct ast *this)
 {
-    struct ast *left = ast_optimize(((struct ast_binary *)this)->left);
-    struct ast *right = ast_optimize(((struct ast_binary *)this)->right);
-    struct ast *ast = ast_binary_new(this->node_type, left, right);
-    if (ast) {
-        ast->value_type = this->value_type;
-        if (ast_is_constant(left) && ast_is_constant(right)) {
-            struct value value;
-            if (ast_evaluate(ast, &value)) {
-                ast_delete(ast);
-                ast = ast_value_new(&value);
-            }
+    struct ast_binary *cmp = (struct ast_binary *)this;
+
+    if (ast_is_constant(cmp->left) && !ast_is_constant(cmp->right)) {
+        struct ast *left = cmp->left;
+        cmp->left = cmp->right;
+        cmp->right = left;
+        this->node_type = compare_mirror(this->node_type);
+    }
+
+    if (!ast_is_constant(cmp->right) || (cmp->right->value_type & PTR)
+            || !value_type_is_int(cmp->right->value_type)) {
+        return this;
+    }
+
+    while ((this->node_type == AST_EQ || this->node_type == AST_NEQ)
+            && ast_compare_solve(a, &this));
+    return this;
+}
+
+/*
+ * Structural equality of side-effect free ASTs.
+ */
+static int ast_equal(struct ast *a, struct ast *b)
+{
+    if (a->node_type == AST_MEMO)
+        a = ((struct ast_unary *)a)->child;
+    if (b->node_type == AST_MEMO)
+        b = ((struct ast_unary *)b)->child;
+    if (a->node_type != b->node_type || a->value_type != b->value_type)
+        return 0;
+
+    switch (a->node_type) {
+    case AST_VALUE: {
+        size_t size = value_type_sizeof(a->value_type);
+        return !memcmp(&ast_value_of(a)->data, &ast_value_of(b)->data, size);
+    }
+    case AST_VAR:
+        return ((struct ast_var *)a)->symtab == ((struct ast_var *)b)->symtab
+            && ((struct ast_var *)a)->sym == ((struct ast_var *)b)->sym
+            && ((struct ast_var *)a)->size == ((struct ast_var *)b)->size;
+    case AST_NEAR: case AST_WITHIN: case AST_BYTES: case AST_IN:
+        return a == b;
+    case AST_INREGION:
+        if (((struct ast_inregion *)a)->table
+                != ((struct ast_inregion *)b)->table
+                || strcmp(((struct ast_inregion *)a)->pattern,
+                          ((struct ast_inregion *)b)->pattern)) {
+            return 0;
         }
+        /* fall through */
+    case AST_CAST: case AST_DEREF: case AST_NEG: case AST_NOT: case AST_COMPL:
+    case AST_ISPTR: case AST_SCOPE:
+        return ast_equal(((struct ast_unary *)a)->child,
+                         ((struct ast_unary *)b)->child);
+    default:
+        return ast_equal(((struct ast_binary *)a)->left,
+                         ((struct ast_binary *)b)->left)
+            && ast_equal(((struct ast_binary *)a)->right,
+                         ((struct ast_binary *)b)->right);
     }
+}
+
+/*
+ * Merge `x >= lo && x <= hi` of integers into a single unsigned range test
+ * `(unsigned)x - lo <= hi - lo`. Strict bounds are converted to inclusive.
+ */
+static struct ast *ast_range_merge(struct ast_arena *a, struct ast *this)
+{
+    struct ast_binary *and = (struct ast_binary *)this;
+    struct ast_binary *lower = (struct ast_binary *)and->left;
+    struct ast_binary *upper = (struct ast_binary *)and->right;
+    struct ast *x, *sub, *cast, *lo_ast, *d_ast, *ast;
+    const struct value_operations *ops;
+    enum value_type type, utype;
+    struct value lo, hi, d, one, cmp;
+
+    if (lower->tree.node_type == AST_LE || lower->tree.node_type == AST_LT) {
+        lower = (struct ast_binary *)and->right;
+        upper = (struct ast_binary *)and->left;
+    }
+    if ((lower->tree.node_type != AST_GE && lower->tree.node_type != AST_GT)
+            || (upper->tree.node_type != AST_LE
+                && upper->tree.node_type != AST_LT)
+            || !ast_is_constant(lower->right)
+            || !ast_is_constant(upper->right)) {
+        return this;
+    }
+    type = lower->right->value_type;
+    if (!value_type_is_int(type) || (type & PTR)
+            || upper->right->value_type != type
+            || !ast_equal(lower->left, upper->left)) {
+        return this;
+    }
+
+    ops = value_type_ops(type);
+    utype = value_type_unsigned(type);
+    lo = *ast_value_of(lower->right);
+    hi = *ast_value_of(upper->right);
+    value_from_umax(&one, type, 1);
+    if (lower->tree.node_type == AST_GT) {
+        struct value next;
+        if (!ops->add(&lo, &one, &next) || !ops->lt(&lo, &next, &cmp)
+                || value_is_zero(&cmp)) {
+            return this;
+        }
+        lo = next;
+    }
+    if (upper->tree.node_type == AST_LT) {
+        struct value prev;
+        if (!ops->sub(&hi, &one, &prev) || !ops->gt(&hi, &prev, &cmp)
+                || value_is_zero(&cmp)) {
+            return this;
+        }
+        hi = prev;
+    }
+
+    if (!ops->gt(&lo, &hi, &cmp))
+        return this;
+    if (value_is_nonzero(&cmp)) {
+        value_from_umax(&cmp, this->value_type, 0);
+        ast = ast_value_new(a, &cmp);
+        return ast ? ast : this;
+    }
+
+    value_from_umax(&d, utype, value_to_umax(&hi) - value_to_umax(&lo));
+    value_from_umax(&lo, utype, value_to_umax(&lo));
+    x = lower->left;
+    cast = (type != utype) ? ast_cast_new(a, utype, x) : x;
+    lo_ast = ast_value_new(a, &lo);
+    d_ast = ast_value_new(a, &d);
+    if (!cast || !lo_ast || !d_ast || !(sub = ast_sub_new(a, cast, lo_ast))
+            || !(ast = ast_le_new(a, sub, d_ast))) {
+        return this;
+    }
+    sub->value_type = utype;
+    ast->value_type = upper->tree.value_type;
     return ast;
 }
 
-static struct ast *ast_cast_optimize(struct ast *this)
+/*
+ * Cost model of evaluation. Dereferences and builtins reading the target are
+ * far more expensive than arithmetic on values.
+ */
+static const unsigned int ast_node_costs[AST_TYPES] = {
+    /* AST_VALUE */ 0,
+    /* AST_VAR   */ 1,
+
+    /* AST_CAST  */ 1,
+    /* AST_DEREF */ 64,
+    /* AST_USUB  */ 1,
+    /* AST_NOT   */ 1,
+    /* AST_COMPL */ 1,
+
+    /* AST_ADD */ 1,
+    /* AST_SUB */ 1,
+    /* AST_MUL */ 2,
+    /* AST_DIV */ 8,
+    /* AST_MOD */ 8,
+
+    /* AST_AND */ 1,
+    /* AST_XOR */ 1,
+    /* AST_OR  */ 1,
+    /* AST_SHL */ 1,
+    /* AST_SHR */ 1,
+
+    /* AST_EQ  */ 1,
+    /* AST_NEQ */ 1,
+    /* AST_LT  */ 1,
+    /* AST_GT  */ 1,
+    /* AST_LE  */ 1,
+    /* AST_GE  */ 1,
+
+    /* AST_AND_COND */ 1,
+    /* AST_OR_COND  */ 1,
+
+    /* AST_ISPTR    */ 32,
+    /* AST_INREGION */ 64,
+    /* AST_NEAR     */ 4,
+    /* AST_WITHIN   */ 64,
+    /* AST_BYTES    */ 64,
+
+    /* AST_IN */ 4,
+
+    /* AST_MEMO  */ 1,
+    /* AST_SCOPE */ 0
+};
+
+static unsigned long ast_cost(struct ast *ast)
+{
+    unsigned long cost = ast_node_costs[ast->node_type];
+    if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        cost += ast_cost(((struct ast_binary *)ast)->left)
+              + ast_cost(((struct ast_binary *)ast)->right);
+    } else if (ast->node_type >= AST_CAST) {
+        cost += ast_cost(((struct ast_unary *)ast)->child);
+    }
+    if (ast->node_type == AST_NEAR) {
+        cost += ast_cost(((struct ast_near *)ast)->center)
+              + ast_cost(((struct ast_near *)ast)->tolerance);
+    }
+    if (ast->node_type == AST_WITHIN) {
+        size_t i;
+        struct ast_within *within = (struct ast_within *)ast;
+        cost += ast_cost(within->radius) + ast_cost(within->stride);
+        for (i = 0; !within->center && i < within->size; i++)
+            cost += ast_cost(within->elements[i]);
+    }
+    if (ast->node_type == AST_IN && !((struct ast_in *)ast)->members) {
+        size_t i;
+        struct ast_in *in = (struct ast_in *)ast;
+        for (i = 0; i < in->size; i++)
+            cost += ast_cost(in->elements[i]) + 1;
+    }
+    return cost;
+}
+
+/* Estimated percentage of evaluations yielding a nonzero value */
+static unsigned int ast_pass_rate(struct ast *ast)
+{
+    struct ast_binary *binary = (struct ast_binary *)ast;
+    unsigned int left, right;
+    int constant;
+
+    if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        constant = ast_is_constant(binary->left)
+                || ast_is_constant(binary->right);
+    } else {
+        constant = 0;
+    }
+
+    switch (ast->node_type) {
+    case AST_VALUE:
+        return value_is_nonzero(ast_value_of(ast)) ? 100 : 0;
+    case AST_NOT:
+        return 100 - ast_pass_rate(((struct ast_unary *)ast)->child);
+    case AST_EQ:
+        return constant ? 1 : 10;
+    case AST_NEQ:
+        return constant ? 99 : 90;
+    case AST_NEAR:
+        return 10;
+    case AST_WITHIN:
+    case AST_BYTES:
+        return 1;
+    case AST_IN:
+        if (!((struct ast_in *)ast)->members)
+            return 10;
+        left = ((struct ast_in *)ast)->members_size;
+        return left < 50 ? left : 50;
+    case AST_AND_COND:
+        left = ast_pass_rate(binary->left);
+        right = ast_pass_rate(binary->right);
+        return left * right / 100;
+    case AST_OR_COND:
+        left = ast_pass_rate(binary->left);
+        right = ast_pass_rate(binary->right);
+        return left + right - left * right / 100;
+    default:
+        break;
+    }
+    return 50;
+}
+
+/*
+ * Test if evaluation of an AST may fail by reading the target or dividing by
+ * a non-constant (or zero) divisor.
+ */
+static int ast_may_fail(struct ast *ast)
+{
+    struct ast_binary *binary = (struct ast_binary *)ast;
+    size_t i;
+
+    switch (ast->node_type) {
+    case AST_VALUE: case AST_VAR:
+        return 0;
+    case AST_DEREF: case AST_ISPTR: case AST_INREGION: case AST_WITHIN:
+    case AST_BYTES:
+        return 1;
+    case AST_DIV: case AST_MOD:
+        if (!ast_is_constant(binary->right)
+                || value_is_zero(ast_value_of(binary->right))) {
+            return 1;
+        }
+        return ast_may_fail(binary->left);
+    case AST_NEAR:
+        return ast_may_fail(((struct ast_unary *)ast)->child)
+            || ast_may_fail(((struct ast_near *)ast)->center)
+            || ast_may_fail(((struct ast_near *)ast)->tolerance);
+    case AST_IN:
+        for (i = 0; !((struct ast_in *)ast)->members
+                    && i < ((struct ast_in *)ast)->size; i++) {
+            if (ast_may_fail(((struct ast_in *)ast)->elements[i]))
+                return 1;
+        }
+        /* fall through */
+    case AST_CAST: case AST_NEG: case AST_NOT: case AST_COMPL:
+    case AST_MEMO: case AST_SCOPE:
+        return ast_may_fail(((struct ast_unary *)ast)->child);
+    default:
+        return ast_may_fail(binary->left) || ast_may_fail(binary->right);
+    }
+}
+
+/*
+ * Order operands of && (||) so that the one with the least cost per rejected
+ * (accepted) value is evaluated first and short-circuits the other, e.g.,
+ * `value % 3 == 1 && value == 7` tests equality first. Operands that may fail
+ * keep their order because failure propagates past a short-circuit guard.
+ */
+static struct ast *ast_cond_reorder(struct ast *this)
+{
+    struct ast_binary *binary = (struct ast_binary *)this;
+    unsigned long left_cost, right_cost;
+    unsigned int left_exit, right_exit;
+
+    if (ast_may_fail(binary->left) || ast_may_fail(binary->right))
+        return this;
+    left_cost = ast_cost(binary->left);
+    right_cost = ast_cost(binary->right);
+    left_exit = ast_pass_rate(binary->left);
+    right_exit = ast_pass_rate(binary->right);
+    if (this->node_type == AST_AND_COND) {
+        left_exit = 100 - left_exit;
+        right_exit = 100 - right_exit;
+    }
+
+    /* left_cost / left_exit > right_cost / right_exit */
+    if (left_cost * right_exit > right_cost * left_exit) {
+        struct ast *tmp = binary->left;
+        binary->left = binary->right;
+        binary->right = tmp;
+    }
+    return this;
+}
+
+static struct ast *ast_binary_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_binary *binary = (struct ast_binary *)this;
+    binary->left = ast_optimize(a, binary->left);
+    binary->right = ast_optimize(a, binary->right);
+    if (ast_is_constant(binary->left) && ast_is_constant(binary->right))
+        return ast_fold(a, this);
+
+    if (ast_type_is_conditional(this->node_type)) {
+        if (this->node_type == AST_AND_COND)
+            this = ast_range_merge(a, this);
+        if (ast_type_is_conditional(this->node_type))
+            this = ast_cond_reorder(this);
+    } else if (ast_type_is_compare(this->node_type)) {
+        this = ast_compare_normalize(a, this);
+    }
+    return this;
+}
+
+static struct ast *ast_cast_optimize(struct ast_arena *a, struct ast *this)
 {
     if ((this->value_type & PTR)) {
-        struct ast *child = ast_optimize(((struct ast_unary *)this)->child);
-        return ast_cast_new(this->value_type, child);
+        struct ast_unary *unary = (struct ast_unary *)this;
+        unary->child = ast_optimize(a, unary->child);
+        return this;
+    }
+    return ast_unary_optimize(a, this);
+}
+
+/* Dereferences and builtins read the target, so they are never folded */
+static struct ast *ast_target_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_unary *unary = (struct ast_unary *)this;
+    unary->child = ast_optimize(a, unary->child);
+    return this;
+}
+
+/*
+ * Sets of constant elements are collected to sorted members.
+ */
+#define AST_IN_COMPARE(field)                                               \
+static int ast_in_compare_##field(const void *a, const void *b)             \
+{                                                                           \
+    const union value_data *x = a, *y = b;                                  \
+    return (x->field > y->field) - (x->field < y->field);                   \
+}
+
+AST_IN_COMPARE(s8)
+AST_IN_COMPARE(u8)
+AST_IN_COMPARE(s16)
+AST_IN_COMPARE(u16)
+AST_IN_COMPARE(s32)
+AST_IN_COMPARE(u32)
+#ifndef NO_64BIT_VALUES
+AST_IN_COMPARE(s64)
+AST_IN_COMPARE(u64)
+#endif
+#ifndef NO_FLOAT_VALUES
+AST_IN_COMPARE(f32)
+AST_IN_COMPARE(f64)
+#endif
+
+static int (*const ast_in_compare[VALUE_TYPES])(const void *, const void *) = {
+    ast_in_compare_s8, ast_in_compare_u8,
+    ast_in_compare_s16, ast_in_compare_u16,
+    ast_in_compare_s32, ast_in_compare_u32,
+    #ifndef NO_64BIT_VALUES
+    ast_in_compare_s64, ast_in_compare_u64,
+    #endif
+    #ifndef NO_FLOAT_VALUES
+    ast_in_compare_f32, ast_in_compare_f64,
+    #endif
+};
+
+/* Sort members of type `type` and remove duplicates (returns the new size) */
+static size_t ast_in_sort(union value_data *members, size_t size,
+                          enum value_type type)
+{
+    int (*compare)(const void *, const void *);
+    size_t i, n;
+    compare = ast_in_compare[value_type_index(type)];
+    qsort(members, size, sizeof(union value_data), compare);
+    for (i = n = 0; i < size; i++) {
+        if (!n || compare(&members[n-1], &members[i]))
+            members[n++] = members[i];
     }
-    return ast_unary_optimize(this);
+    return n;
 }
 
-static struct ast *ast_deref_optimize(struct ast *this)
+static int ast_in_collect(struct ast_arena *a, struct ast_in *in)
 {
-    struct target *target = ((struct ast_deref *)this)->target;
-    struct ast *child = ast_optimize(((struct ast_unary *)this)->child);
-    return ast_deref_new(child, this->value_type, target);
+    enum value_type type = in->tree.child->value_type;
+    union value_data *members;
+    size_t i, n;
+
+    for (i = 0; i < in->size; i++) {
+        if (!ast_is_constant(in->elements[i]))
+            return 0;
+    }
+    if (!(members = ast_arena_alloc(a, in->size * sizeof(union value_data))))
+        return 0;
+    for (i = n = 0; i < in->size; i++) {
+        struct value member, eq;
+        member.type = type;
+        if (value_type_ops(type)->assign(&member, ast_value_of(in->elements[i]))
+                && value_ops(&member)->eq(&member, &member, &eq)
+                && value_is_nonzero(&eq)) { /* NaN is not a member */
+            members[n++] = member.data;
+        }
+    }
+    in->members = members;
+    in->members_size = ast_in_sort(members, n, type);
+    return 1;
 }
 
-struct ast *(*ast_optimize_funcs[AST_TYPES])(struct ast *) = {
-    /* AST_VALUE */ ast_value_optimize,
-    /* AST_VAR   */ ast_var_optimize,
+/*
+ * Test `(T)x in {...}` of an injective cast (from a narrower integer type or
+ * from f32 to f64) as `x in {...}` of the members representable by x.
+ */
+static int ast_in_narrow(struct ast_in *in)
+{
+    struct ast *cast = in->tree.child, *x;
+    enum value_type from, to = cast->value_type;
+    size_t i, n;
+
+    if (cast->node_type != AST_CAST || (to & PTR))
+        return 0;
+    x = ((struct ast_unary *)cast)->child;
+    from = x->value_type;
+    if (!value_type_is_int(from) || !value_type_is_int(to)
+            || value_type_sizeof(from) > value_type_sizeof(to)) {
+        #ifndef NO_FLOAT_VALUES
+        if (from != F32 || to != F64)
+        #endif
+            return 0;
+    }
+
+    for (i = n = 0; i < in->members_size; i++) {
+        struct value member, narrow, back;
+        member.type = to;
+        member.data = in->members[i];
+        if (value_type_ops(from)->assign(&narrow, &member)
+                && value_type_ops(to)->assign(&back, &narrow)
+                && !memcmp(&back.data, &member.data, value_type_sizeof(to))) {
+            in->members[n++] = narrow.data;
+        }
+    }
+    in->members_size = ast_in_sort(in->members, n, from);
+    in->tree.child = x;
+    return 1;
+}
+
+static struct ast *ast_in_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_in *in = (struct ast_in *)this;
+    size_t i;
+
+    in->tree.child = ast_optimize(a, in->tree.child);
+    if (!in->members) {
+        for (i = 0; i < in->size; i++)
+            in->elements[i] = ast_optimize(a, in->elements[i]);
+        if (!ast_in_collect(a, in))
+            return this;
+    }
+    while (ast_in_narrow(in));
+    return ast_is_constant(in->tree.child) ? ast_fold(a, this) : this;
+}
+
+/* Compute bounds of an approximate comparison of constant operands */
+static void ast_near_bound(struct ast_near *near)
+{
+    if (!near->bounded && ast_is_constant(near->center)
+            && ast_is_constant(near->tolerance)) {
+        near->bounded = value_near_bounds(near->mode,
+                                          near->tree.child->value_type,
+                                          ast_value_of(near->center),
+                                          ast_value_of(near->tolerance),
+                                          &near->lo, &near->hi);
+    }
+}
+
+static struct ast *ast_near_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_near *near = (struct ast_near *)this;
+    near->tree.child = ast_optimize(a, near->tree.child);
+    near->center = ast_optimize(a, near->center);
+    near->tolerance = ast_optimize(a, near->tolerance);
+    ast_near_bound(near);
+    return (near->bounded && ast_is_constant(near->tree.child))
+         ? ast_fold(a, this) : this;
+}
+
+/* Collect the constant point and radius of within() */
+static int ast_within_collect(struct ast_arena *a, struct ast_within *within)
+{
+#ifndef NO_FLOAT_VALUES
+    struct value c;
+    double *center;
+    size_t i;
+
+    if (!ast_is_constant(within->radius) || !ast_is_constant(within->stride))
+        return 0;
+    for (i = 0; i < within->size; i++) {
+        if (!ast_is_constant(within->elements[i]))
+            return 0;
+    }
+    if (!(center = ast_arena_alloc(a, within->size * sizeof(double))))
+        return 0;
+    for (i = 0; i < within->size; i++) {
+        struct value *element = ast_value_of(within->elements[i]);
+        if (!value_ops(element)->cast_to_f64(element, &c))
+            return 0;
+        center[i] = c.data.f64;
+    }
+    if (!value_ops(ast_value_of(within->radius))->cast_to_f64(
+                ast_value_of(within->radius), &c)) {
+        return 0;
+    }
+    within->radius2 = (c.data.f64 < 0) ? -1 : c.data.f64 * c.data.f64;
+    within->step = (addr_t)value_to_umax(ast_value_of(within->stride));
+    within->center = center;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static struct ast *ast_within_optimize(struct ast_arena *a, struct ast *this)
+{
+    struct ast_within *within = (struct ast_within *)this;
+    size_t i;
+
+    within->tree.child = ast_optimize(a, within->tree.child);
+    if (!within->center) {
+        for (i = 0; i < within->size; i++)
+            within->elements[i] = ast_optimize(a, within->elements[i]);
+        within->radius = ast_optimize(a, within->radius);
+        within->stride = ast_optimize(a, within->stride);
+        ast_within_collect(a, within);
+    }
+    return this;
+}
+
+/* Shared subexpressions are unshared */
+static struct ast *ast_memo_optimize(struct ast_arena *a, struct ast *this)
+{
+    return ast_optimize(a, ((struct ast_unary *)this)->child);
+}
+
+struct ast *(*ast_optimize_funcs[AST_TYPES])(struct ast_arena *,
+                                             struct ast *) = {
+    /* AST_VALUE */ ast_leaf_optimize,
+    /* AST_VAR   */ ast_leaf_optimize,
 
     /* AST_CAST  */ ast_cast_optimize,
-    /* AST_DEREF */ ast_deref_optimize,
+    /* AST_DEREF */ ast_target_optimize,
     /* AST_USUB  */ ast_unary_optimize,
     /* AST_NOT   */ ast_unary_optimize,
     /* AST_COMPL */ ast_unary_optimize,
@@ -98,5 +799,653 @@ struct ast *(*ast_optimize_funcs[AST_TYPES])(struct ast *) = {
     /* AST_GE  */ ast_binary_optimize,
 
     /* AST_AND_COND */ ast_binary_optimize,
-    /* AST_OR_COND  */ ast_binary_optimize
+    /* AST_OR_COND  */ ast_binary_optimize,
+
+    /* AST_ISPTR    */ ast_target_optimize,
+    /* AST_INREGION */ ast_target_optimize,
+    /* AST_NEAR     */ ast_near_optimize,
+    /* AST_WITHIN   */ ast_within_optimize,
+    /* AST_BYTES    */ ast_target_optimize,
+
+    /* AST_IN */ ast_in_optimize,
+
+    /* AST_MEMO  */ ast_memo_optimize,
+    /* AST_SCOPE */ ast_memo_optimize
 };
+
+static unsigned long ast_value_depends(struct ast *this)
+{
+    return 0;
+}
+
+static unsigned long ast_var_depends(struct ast *this)
+{
+    return AST_DEPENDS_SYMBOL(((struct ast_var *)this)->sym);
+}
+
+static unsigned long ast_unary_depends(struct ast *this)
+{
+    return ast_depends(((struct ast_unary *)this)->child);
+}
+
+static unsigned long ast_binary_depends(struct ast *this)
+{
+    return ast_depends(((struct ast_binary *)this)->left)
+         | ast_depends(((struct ast_binary *)this)->right);
+}
+
+static unsigned long ast_target_depends(struct ast *this)
+{
+    return AST_DEPENDS_TARGET | ast_unary_depends(this);
+}
+
+static unsigned long ast_in_depends(struct ast *this)
+{
+    struct ast_in *in = (struct ast_in *)this;
+    unsigned long depends = ast_unary_depends(this);
+    size_t i;
+    for (i = 0; !in->members && i < in->size; i++)
+        depends |= ast_depends(in->elements[i]);
+    return depends;
+}
+
+static unsigned long ast_near_depends(struct ast *this)
+{
+    return ast_unary_depends(this)
+         | ast_depends(((struct ast_near *)this)->center)
+         | ast_depends(((struct ast_near *)this)->tolerance);
+}
+
+static unsigned long ast_within_depends(struct ast *this)
+{
+    struct ast_within *within = (struct ast_within *)this;
+    unsigned long depends = ast_target_depends(this);
+    size_t i;
+    if (!within->center) {
+        for (i = 0; i < within->size; i++)
+            depends |= ast_depends(within->elements[i]);
+        depends |= ast_depends(within->radius) | ast_depends(within->stride);
+    }
+    return depends;
+}
+
+unsigned long (*ast_depends_funcs[AST_TYPES])(struct ast *) = {
+    /* AST_VALUE */ ast_value_depends,
+    /* AST_VAR   */ ast_var_depends,
+
+    /* AST_CAST  */ ast_unary_depends,
+    /* AST_DEREF */ ast_target_depends,
+    /* AST_USUB  */ ast_unary_depends,
+    /* AST_NOT   */ ast_unary_depends,
+    /* AST_COMPL */ ast_unary_depends,
+
+    /* AST_ADD */ ast_binary_depends,
+    /* AST_SUB */ ast_binary_depends,
+    /* AST_MUL */ ast_binary_depends,
+    /* AST_DIV */ ast_binary_depends,
+    /* AST_MOD */ ast_binary_depends,
+
+    /* AST_AND */ ast_binary_depends,
+    /* AST_XOR */ ast_binary_depends,
+    /* AST_OR  */ ast_binary_depends,
+    /* AST_SHL */ ast_binary_depends,
+    /* AST_SHR */ ast_binary_depends,
+
+    /* AST_EQ  */ ast_binary_depends,
+    /* AST_NEQ */ ast_binary_depends,
+    /* AST_LT  */ ast_binary_depends,
+    /* AST_GT  */ ast_binary_depends,
+    /* AST_LE  */ ast_binary_depends,
+    /* AST_GE  */ ast_binary_depends,
+
+    /* AST_AND_COND */ ast_binary_depends,
+    /* AST_OR_COND  */ ast_binary_depends,
+
+    /* AST_ISPTR    */ ast_target_depends,
+    /* AST_INREGION */ ast_target_depends,
+    /* AST_NEAR     */ ast_near_depends,
+    /* AST_WITHIN   */ ast_within_depends,
+    /* AST_BYTES    */ ast_target_depends,
+
+    /* AST_IN */ ast_in_depends,
+
+    /* AST_MEMO  */ ast_unary_depends,
+    /* AST_SCOPE */ ast_unary_depends
+};
+
+static void ast_leaf_hoist(struct ast_arena *a, struct ast *this)
+{
+    return;
+}
+
+static void ast_unary_hoist(struct ast_arena *a, struct ast *this)
+{
+    struct ast_unary *unary = (struct ast_unary *)this;
+    unary->child = ast_hoist(a, unary->child);
+}
+
+static void ast_binary_hoist(struct ast_arena *a, struct ast *this)
+{
+    struct ast_binary *binary = (struct ast_binary *)this;
+    binary->left = ast_hoist(a, binary->left);
+    binary->right = ast_hoist(a, binary->right);
+}
+
+static void ast_in_hoist(struct ast_arena *a, struct ast *this)
+{
+    struct ast_in *in = (struct ast_in *)this;
+    size_t i;
+
+    in->tree.child = ast_hoist(a, in->tree.child);
+    if (!in->members) {
+        for (i = 0; i < in->size; i++)
+            in->elements[i] = ast_hoist(a, in->elements[i]);
+        if (ast_in_collect(a, in))
+            while (ast_in_narrow(in));
+    }
+}
+
+static void ast_near_hoist(struct ast_arena *a, struct ast *this)
+{
+    struct ast_near *near = (struct ast_near *)this;
+    near->tree.child = ast_hoist(a, near->tree.child);
+    near->center = ast_hoist(a, near->center);
+    near->tolerance = ast_hoist(a, near->tolerance);
+    ast_near_bound(near);
+}
+
+static void ast_within_hoist(struct ast_arena *a, struct ast *this)
+{
+    struct ast_within *within = (struct ast_within *)this;
+    size_t i;
+
+    within->tree.child = ast_hoist(a, within->tree.child);
+    if (!within->center) {
+        for (i = 0; i < within->size; i++)
+            within->elements[i] = ast_hoist(a, within->elements[i]);
+        within->radius = ast_hoist(a, within->radius);
+        within->stride = ast_hoist(a, within->stride);
+        ast_within_collect(a, within);
+    }
+}
+
+static void (*ast_hoist_funcs[AST_TYPES])(struct ast_arena *, struct ast *) = {
+    /* AST_VALUE */ ast_leaf_hoist,
+    /* AST_VAR   */ ast_leaf_hoist,
+
+    /* AST_CAST  */ ast_unary_hoist,
+    /* AST_DEREF */ ast_unary_hoist,
+    /* AST_USUB  */ ast_unary_hoist,
+    /* AST_NOT   */ ast_unary_hoist,
+    /* AST_COMPL */ ast_unary_hoist,
+
+    /* AST_ADD */ ast_binary_hoist,
+    /* AST_SUB */ ast_binary_hoist,
+    /* AST_MUL */ ast_binary_hoist,
+    /* AST_DIV */ ast_binary_hoist,
+    /* AST_MOD */ ast_binary_hoist,
+
+    /* AST_AND */ ast_binary_hoist,
+    /* AST_XOR */ ast_binary_hoist,
+    /* AST_OR  */ ast_binary_hoist,
+    /* AST_SHL */ ast_binary_hoist,
+    /* AST_SHR */ ast_binary_hoist,
+
+    /* AST_EQ  */ ast_binary_hoist,
+    /* AST_NEQ */ ast_binary_hoist,
+    /* AST_LT  */ ast_binary_hoist,
+    /* AST_GT  */ ast_binary_hoist,
+    /* AST_LE  */ ast_binary_hoist,
+    /* AST_GE  */ ast_binary_hoist,
+
+    /* AST_AND_COND */ ast_binary_hoist,
+    /* AST_OR_COND  */ ast_binary_hoist,
+
+    /* AST_ISPTR    */ ast_unary_hoist,
+    /* AST_INREGION */ ast_unary_hoist,
+    /* AST_NEAR     */ ast_near_hoist,
+    /* AST_WITHIN   */ ast_within_hoist,
+    /* AST_BYTES    */ ast_unary_hoist,
+
+    /* AST_IN */ ast_in_hoist,
+
+    /* AST_MEMO  */ ast_unary_hoist,
+    /* AST_SCOPE */ ast_unary_hoist
+};
+
+/*
+ * Pointer-typed subtrees are kept as casts (which the parser and evaluation
+ * of dereferences expect), but their children are hoisted.
+ */
+struct ast *ast_hoist(struct ast_arena *a, struct ast *ast)
+{
+    if (ast->node_type != AST_VALUE && !(ast->value_type & PTR)
+            && !(ast_depends(ast) & ~AST_DEPENDS_TARGET)) {
+        struct value value;
+        struct ast *hoisted;
+        if (ast_evaluate(ast, &value) && (hoisted = ast_value_new(a, &value))) {
+            hoisted->value_type = ast->value_type;
+            return hoisted;
+        }
+    }
+    ast_hoist_funcs[ast->node_type](a, ast);
+    return ast;
+}
+
+static int ast_compare_predicate(struct ast *ast, size_t sym,
+                                 struct ast_predicate *out)
+{
+    struct ast_binary *cmp = (struct ast_binary *)ast;
+    if (!ast_type_is_compare(ast->node_type)
+            || ast_type_is_conditional(ast->node_type)
+            || cmp->left->node_type != AST_VAR
+            || ((struct ast_var *)cmp->left)->sym != sym
+            || !ast_is_constant(cmp->right)
+            || cmp->left->value_type != cmp->right->value_type
+            || (cmp->left->value_type & PTR)) {
+        return 0;
+    }
+    out->op = ast->node_type;
+    out->type = cmp->left->value_type;
+    out->lo = out->hi = *ast_value_of(cmp->right);
+    return 1;
+}
+
+int ast_predicate(struct ast *ast, size_t sym, struct ast_predicate *out)
+{
+    struct ast_binary *binary = (struct ast_binary *)ast;
+
+    if (ast_compare_predicate(ast, sym, out))
+        return 1;
+
+    if (ast->node_type == AST_LE && binary->left->node_type == AST_SUB
+            && ast_is_constant(binary->right)
+            && ast_is_constant(((struct ast_binary *)binary->left)->right)) {
+        /* Range test `(unsigned)var - lo <= hi - lo` of ast_range_merge() */
+        struct ast_binary *sub = (struct ast_binary *)binary->left;
+        struct ast *x = sub->left;
+        if (x->node_type == AST_CAST && !(x->value_type & PTR))
+            x = ((struct ast_unary *)x)->child;
+        if (x->node_type == AST_VAR && ((struct ast_var *)x)->sym == sym
+                && value_type_is_int(x->value_type)
+                && !(x->value_type & PTR)
+                && value_type_unsigned(x->value_type) == sub->tree.value_type
+                && binary->right->value_type == sub->tree.value_type) {
+            struct value *lo = ast_value_of(sub->right);
+            struct value *d = ast_value_of(binary->right);
+            out->op = AST_AND_COND;
+            out->type = x->value_type;
+            value_type_ops(out->type)->assign(&out->lo, lo);
+            value_from_umax(&out->hi, out->type,
+                            value_to_umax(lo) + value_to_umax(d));
+            return 1;
+        }
+    }
+
+    if (ast->node_type == AST_IN) {
+        struct ast_in *in = (struct ast_in *)ast;
+        struct ast *x = in->tree.child;
+        if (in->members && in->members_size && x->node_type == AST_VAR
+                && ((struct ast_var *)x)->sym == sym
+                && !(x->value_type & PTR)) {
+            out->op = AST_IN;
+            out->type = out->lo.type = out->hi.type = x->value_type;
+            out->lo.data = in->members[0];
+            out->hi.data = in->members[in->members_size - 1];
+            out->members = in->members;
+            out->size = in->members_size;
+            return 1;
+        }
+    }
+
+    if (ast->node_type == AST_NEAR) {
+        struct ast_near *near = (struct ast_near *)ast;
+        struct ast *x = near->tree.child;
+        if (near->bounded && x->node_type == AST_VAR
+                && ((struct ast_var *)x)->sym == sym) {
+            out->op = AST_AND_COND;
+            out->type = x->value_type;
+            out->lo = near->lo;
+            out->hi = near->hi;
+            return 1;
+        }
+    }
+
+    if (ast->node_type == AST_WITHIN) {
+        struct ast_within *within = (struct ast_within *)ast;
+        struct ast *x = within->tree.child;
+        if (within->center && x->node_type == AST_VAR) {
+            out->op = AST_WITHIN;
+            out->type = within->type;
+            out->size = within->size;
+            out->addr = ((struct ast_var *)x)->sym;
+            out->stride = within->step;
+            out->center = within->center;
+            out->radius2 = within->radius2;
+            return 1;
+        }
+    }
+
+    if (ast->node_type == AST_BYTES) {
+        struct ast_bytes *bytes = (struct ast_bytes *)ast;
+        struct ast *x = bytes->tree.child;
+        if (x->node_type == AST_VAR) {
+            out->op = AST_BYTES;
+            out->type = U8;
+            out->size = bytes->size;
+            out->addr = ((struct ast_var *)x)->sym;
+            out->pattern = bytes->pattern;
+            out->mask = bytes->mask;
+            out->anchor = bytes->anchor;
+            return 1;
+        }
+    }
+
+    if (ast->node_type == AST_AND_COND) {
+        struct ast_predicate lower, upper;
+        if (ast_compare_predicate(binary->left, sym, &lower)
+                && ast_compare_predicate(binary->right, sym, &upper)
+                && lower.type == upper.type) {
+            if (lower.op == AST_LE && upper.op == AST_GE) {
+                struct ast_predicate tmp = lower;
+                lower = upper;
+                upper = tmp;
+            }
+            if (lower.op == AST_GE && upper.op == AST_LE) {
+                out->op = AST_AND_COND;
+                out->type = lower.type;
+                out->lo = lower.lo;
+                out->hi = upper.lo;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int ast_anchor(struct ast *ast, size_t sym, struct ast_predicate *out)
+{
+    struct ast_binary *binary = (struct ast_binary *)ast;
+    struct ast_predicate right;
+
+    if (ast_predicate(ast, sym, out)) {
+        out->pass_rate = ast_pass_rate(ast);
+        return 1;
+    }
+    if (ast->node_type == AST_SCOPE)
+        return ast_anchor(((struct ast_unary *)ast)->child, sym, out);
+    if (ast->node_type != AST_AND_COND)
+        return 0;
+    if (!ast_anchor(binary->left, sym, out))
+        return ast_anchor(binary->right, sym, out);
+    if (ast_anchor(binary->right, sym, &right)
+            && right.pass_rate < out->pass_rate) {
+        *out = right;
+    }
+    return 1;
+}
+
+static int ast_is_var(struct ast *ast, size_t sym)
+{
+    return ast->node_type == AST_VAR && ((struct ast_var *)ast)->sym == sym
+        && value_type_is_int(ast->value_type) && !(ast->value_type & PTR)
+        && !value_type_is_signed(ast->value_type);
+}
+
+/* Bounds that no value satisfies */
+static int ast_bounds_empty(struct ast_bounds *out)
+{
+    out->lo = 1;
+    out->hi = 0;
+    return 1;
+}
+
+/* Add constraint sym % mod == rem (keeping the stricter of two moduli) */
+static int ast_bounds_mod(struct ast_bounds *out, umax_t mod, umax_t rem)
+{
+    if (rem >= mod)
+        return ast_bounds_empty(out);
+    if (!out->mod || (mod % out->mod == 0 && rem % out->mod == out->rem)) {
+        out->mod = mod;
+        out->rem = rem;
+    } else if (out->mod % mod == 0 && out->rem % mod != rem) {
+        return ast_bounds_empty(out);
+    }
+    return 1;
+}
+
+static int ast_bounds_collect(struct ast *ast, size_t sym,
+                              struct ast_bounds *out)
+{
+    struct ast_binary *binary = (struct ast_binary *)ast;
+    struct ast_predicate pred;
+
+    if (ast->node_type == AST_AND_COND) {
+        int left = ast_bounds_collect(binary->left, sym, out);
+        int right = ast_bounds_collect(binary->right, sym, out);
+        return left || right;
+    }
+
+    if (ast->node_type == AST_INREGION) {
+        if (!ast_is_var(((struct ast_unary *)ast)->child, sym))
+            return 0;
+        out->region = ((struct ast_inregion *)ast)->pattern;
+        return 1;
+    }
+
+    if (ast->node_type == AST_EQ && ast_is_constant(binary->right)
+            && (binary->left->node_type == AST_MOD
+                || binary->left->node_type == AST_AND)) {
+        /* sym % mod == rem, or sym & (mod-1) == rem for powers of two */
+        struct ast_binary *op = (struct ast_binary *)binary->left;
+        umax_t k, rem;
+        if (!ast_is_var(op->left, sym) || !ast_is_constant(op->right)
+                || op->right->value_type != op->left->value_type
+                || binary->right->value_type != op->left->value_type) {
+            return 0;
+        }
+        k = value_to_umax(ast_value_of(op->right));
+        rem = value_to_umax(ast_value_of(binary->right));
+        if (op->tree.node_type == AST_AND) {
+            if (k & (k + 1) || !(k + 1))
+                return 0;
+            k++;
+        }
+        return k && ast_bounds_mod(out, k, rem);
+    }
+
+    if (ast_predicate(ast, sym, &pred) && value_type_is_int(pred.type)
+            && !value_type_is_signed(pred.type)
+            && pred.op != AST_WITHIN && pred.op != AST_BYTES) {
+        umax_t lo = value_to_umax(&pred.lo), hi = value_to_umax(&pred.hi);
+        switch (pred.op) {
+        case AST_EQ:
+            hi = lo;
+            break;
+        case AST_LT:
+            if (!lo)
+                return ast_bounds_empty(out);
+            hi = lo - 1;
+            lo = 0;
+            break;
+        case AST_GT:
+            if (lo == (umax_t)-1)
+                return ast_bounds_empty(out);
+            lo++;
+            hi = (umax_t)-1;
+            break;
+        case AST_LE:
+            hi = lo;
+            lo = 0;
+            break;
+        case AST_GE:
+            hi = (umax_t)-1;
+            break;
+        case AST_AND_COND:
+        case AST_IN:
+            break;
+        default:
+            return 0;
+        }
+        if (out->lo < lo)
+            out->lo = lo;
+        if (out->hi > hi)
+            out->hi = hi;
+        return 1;
+    }
+    return 0;
+}
+
+int ast_bounds(struct ast *ast, size_t sym, struct ast_bounds *out)
+{
+    out->lo = 0;
+    out->hi = (umax_t)-1;
+    out->mod = out->rem = 0;
+    out->region = NULL;
+    return ast_bounds_collect(ast, sym, out);
+}
+
+/*
+ * Common subexpression elimination.
+ *
+ * Distinct subtrees are hash-consed into a table counting their occurrences
+ * (occurrences of a repeated subtree are not descended into). Then repeated
+ * subtrees are replaced by a memo node shared by all of its occurrences.
+ */
+struct cse_entry {
+    struct ast *ast;
+    unsigned long hash;
+    size_t count;
+    struct ast *memo;
+};
+
+struct cse_table {
+    struct cse_entry *entries;
+    size_t size, capacity;
+};
+
+static unsigned long ast_hash(struct ast *ast)
+{
+    unsigned long hash;
+    if (ast->node_type == AST_MEMO)
+        ast = ((struct ast_unary *)ast)->child;
+
+    hash = (unsigned long)ast->node_type * 31 + (unsigned long)ast->value_type;
+    if (ast->node_type == AST_VALUE) {
+        const unsigned char *data;
+        size_t i, size = value_type_sizeof(ast->value_type);
+        data = (const unsigned char *)&ast_value_of(ast)->data;
+        for (i = 0; i < size; i++)
+            hash = hash * 31 + data[i];
+    } else if (ast->node_type == AST_VAR) {
+        hash = hash * 31 + ((struct ast_var *)ast)->sym;
+    } else if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        hash = hash * 31 + ast_hash(((struct ast_binary *)ast)->left);
+        hash = hash * 31 + ast_hash(((struct ast_binary *)ast)->right);
+    } else {
+        hash = hash * 31 + ast_hash(((struct ast_unary *)ast)->child);
+    }
+    return hash;
+}
+
+static struct cse_entry *cse_find(struct cse_table *table, struct ast *ast,
+                                  unsigned long hash)
+{
+    size_t i;
+    for (i = 0; i < table->size; i++) {
+        struct cse_entry *entry = &table->entries[i];
+        if (entry->hash == hash && ast_equal(entry->ast, ast))
+            return entry;
+    }
+    return NULL;
+}
+
+static int cse_count(struct cse_table *table, struct ast *ast)
+{
+    unsigned long hash = ast_hash(ast);
+    struct cse_entry *entry;
+
+    if ((entry = cse_find(table, ast, hash))) {
+        entry->count++;
+        return 1;
+    }
+    if (table->size == table->capacity) {
+        size_t capacity = table->capacity ? 2*table->capacity : 16;
+        size_t size = capacity * sizeof(struct cse_entry);
+        if (!(entry = realloc(table->entries, size)))
+            return 0;
+        table->entries = entry;
+        table->capacity = capacity;
+    }
+    entry = &table->entries[table->size++];
+    entry->ast = ast;
+    entry->hash = hash;
+    entry->count = 1;
+    entry->memo = NULL;
+
+    if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        return cse_count(table, ((struct ast_binary *)ast)->left)
+            && cse_count(table, ((struct ast_binary *)ast)->right);
+    } else if (ast->node_type >= AST_CAST) {
+        return cse_count(table, ((struct ast_unary *)ast)->child);
+    }
+    return 1;
+}
+
+static struct ast *cse_rewrite(struct ast_arena *a, struct cse_table *table,
+                               struct ast *ast, struct ast_scope *scope)
+{
+    struct cse_entry *entry = cse_find(table, ast, ast_hash(ast));
+
+    /* Share repeated subtrees costing more than a memo lookup */
+    if (entry && entry->count > 1 && entry->memo)
+        return entry->memo;
+
+    if (ast->node_type >= AST_ADD && ast->node_type <= AST_OR_COND) {
+        struct ast_binary *binary = (struct ast_binary *)ast;
+        binary->left = cse_rewrite(a, table, binary->left, scope);
+        binary->right = cse_rewrite(a, table, binary->right, scope);
+    } else if (ast->node_type >= AST_CAST) {
+        struct ast_unary *unary = (struct ast_unary *)ast;
+        unary->child = cse_rewrite(a, table, unary->child, scope);
+    }
+
+    if (entry && entry->count > 1 && !(ast->value_type & PTR)
+            && ast_cost(ast) > ast_node_costs[AST_MEMO]) {
+        struct ast *memo;
+        if ((memo = ast_memo_new(a, ast, scope))) {
+            entry->memo = memo;
+            return memo;
+        }
+    }
+    return ast;
+}
+
+struct ast *ast_cse(struct ast_arena *a, struct ast *ast)
+{
+    struct cse_table table;
+    struct ast *scope;
+    size_t i;
+
+    table.entries = NULL;
+    table.size = table.capacity = 0;
+    if (!cse_count(&table, ast)) {
+        free(table.entries);
+        return ast;
+    }
+    for (i = 0; i < table.size; i++) {
+        if (table.entries[i].count > 1)
+            break;
+    }
+    if (i == table.size || !(scope = ast_scope_new(a, NULL))) {
+        free(table.entries);
+        return ast;
+    }
+
+    ast = cse_rewrite(a, &table, ast, (struct ast_scope *)scope);
+    ((struct ast_unary *)scope)->child = ast;
+    scope->value_type = ast->value_type;
+    free(table.entries);
+    return scope;
+}
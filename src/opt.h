@@ -9,12 +9,99 @@
 #include "ast.h"
 
 /*
- * Optimize an AST.
+ * Optimize an AST in-place.
  *
- * Returns an optimized copy of the passed in AST. ast_delete() must be called
- * for the returned optimized AST as well as the original passed in AST.
+ * Returns the optimized AST, which replaces `ast`. Nodes of `ast` are reused
+ * (or abandoned) and new nodes are allocated from the arena `a`.
  */
-extern struct ast *(*ast_optimize_funcs[AST_TYPES])(struct ast *);
-#define ast_optimize(ast) (ast_optimize_funcs[(ast)->node_type]((ast)))
+extern struct ast *(*ast_optimize_funcs[AST_TYPES])(struct ast_arena *,
+                                                    struct ast *);
+#define ast_optimize(a, ast) (ast_optimize_funcs[(ast)->node_type]((a), (ast)))
+
+/*
+ * Dependencies of an AST.
+ *
+ * Returns a bit mask with AST_DEPENDS_TARGET set if evaluating the AST reads
+ * the target (memory or regions), and AST_DEPENDS_SYMBOL(sym) set for each
+ * referenced symbol `sym` of the symbol table.
+ */
+#define AST_DEPENDS_TARGET 1UL
+#define AST_DEPENDS_SYMBOL(sym) ((sym) < 32 ? 1UL << (sym) : ~1UL)
+extern unsigned long (*ast_depends_funcs[AST_TYPES])(struct ast *);
+#define ast_depends(ast) (ast_depends_funcs[(ast)->node_type]((ast)))
+
+/*
+ * Predicate descriptor of a normalized AST comparing a variable against
+ * constants. `op` is one of AST_EQ...AST_GE comparing the variable to `lo`,
+ * AST_AND_COND for an inclusive range test `lo <= var && var <= hi`, or
+ * AST_IN for a membership test of `size` sorted `members` (the least and
+ * greatest of which are `lo` and `hi`). Constants are of the variable type.
+ *
+ * AST_WITHIN describes a within() of `size` values of the type `type` at
+ * `stride` bytes apart from the address symbol `addr` (instead of `sym`),
+ * i.e., their squared distance from `center` is at most `radius2`. Likewise,
+ * AST_BYTES describes a bytes() pattern of `size` bytes at `addr` (of type
+ * U8) with a wildcard-free byte at index `anchor` (see struct ast_bytes).
+ */
+struct ast_predicate {
+    enum ast_type op;
+    enum value_type type;
+    struct value lo, hi;
+    const union value_data *members;
+    size_t size;
+
+    size_t addr, stride;
+    const double *center;
+    double radius2;
+    const unsigned char *pattern, *mask;
+    size_t anchor;
+
+    /* Estimated percentage of values satisfying the predicate */
+    unsigned int pass_rate;
+};
+
+/* Describe an optimized AST as a predicate of symbol `sym` (0 if unable) */
+int ast_predicate(struct ast *ast, size_t sym, struct ast_predicate *out);
+
+/*
+ * Describe the most selective conjunct of an && chain that is a predicate of
+ * symbol `sym` (0 if none). The whole AST holds only if the predicate does.
+ */
+int ast_anchor(struct ast *ast, size_t sym, struct ast_predicate *out);
+
+/*
+ * Bounds of an unsigned integer symbol implied by an AST, i.e., the AST can
+ * be true only if lo <= sym <= hi, sym % mod == rem (if mod is nonzero) and,
+ * if region is non-NULL, sym is in a region whose path contains `region`.
+ */
+struct ast_bounds {
+    umax_t lo, hi;
+    umax_t mod, rem;
+    const char *region;
+};
+
+/* Collect bounds of symbol `sym` from && conjuncts (0 if none found) */
+int ast_bounds(struct ast *ast, size_t sym, struct ast_bounds *out);
+
+/*
+ * Hoist loop-invariant subtrees of an AST.
+ *
+ * Subtrees that do not depend on any symbol are evaluated and replaced by
+ * constants in-place. Unlike ast_optimize(), this also folds dereferences and
+ * other subtrees reading the target, so the AST should be hoisted only right
+ * before evaluating it repeatedly (e.g., for each address of a search) while
+ * the target is stopped. Returns the hoisted AST, which replaces `ast`.
+ */
+struct ast *ast_hoist(struct ast_arena *a, struct ast *ast);
+
+/*
+ * Common subexpression elimination.
+ *
+ * Repeated subtrees (e.g., the same dereference in several clauses) of an
+ * optimized AST are shared and evaluated once per evaluation of the returned
+ * AST, which replaces `ast`. The shared subtrees are valid only within the
+ * returned AST, so it should not be optimized or combined further.
+ */
+struct ast *ast_cse(struct ast_arena *a, struct ast *ast);
 
 #endif
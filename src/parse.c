@@ -1,8 +1,10 @@
 #define _DEFAULT_SOURCE /* vfprintf(3) */
 #include "parse.h"
 #include "ramfuck.h"
+#include "target.h"
 #include "value.h"
 
+#include <ctype.h>
 #include <memory.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -88,7 +90,8 @@ static int accept_typecast(struct parser *p, enum value_type *type, int *ptrs)
         if (accept(p, LEX_IDENTIFIER)) {
             size_t len = p->accepted->value.identifier.len;
             const char *name = p->accepted->value.identifier.name;
-            if ((*type = value_type_from_substring(name, len))) {
+            if ((*type = value_type_from_substring(name, len))
+                    && !value_type_is_swapped(*type)) {
                 for (*ptrs = 0; accept(p, LEX_MUL); (*ptrs)++);
                 if (accept(p, LEX_RIGHT_PARENTHESIS))
                     return 1;
@@ -101,16 +104,12 @@ static int accept_typecast(struct parser *p, enum value_type *type, int *ptrs)
     return 0;
 }
 
-static struct ast *promote_type(struct ast *ast, enum value_type type)
+static struct ast *promote_type(struct parser *p, struct ast *ast,
+                               enum value_type type)
 {
     if (ast->value_type < type) {
         struct ast *cast;
-        if ((cast = ast_cast_new(type, ast))) {
-            ast = cast;
-        } else {
-            ast_delete(ast);
-            ast = NULL;
-        }
+        ast = (cast = ast_cast_new(p->arena, type, ast)) ? cast : NULL;
     }
     return ast;
 }
@@ -135,15 +134,141 @@ struct ast *parse_expression(struct parser *p, const char *in)
             parse_error(p, "EOL expected before '%s'", tokenstr);
             do { next_symbol(p); } while (p->symbol->type != LEX_EOL);
         }
-        if (p->errors > errors) {
-            ast_delete(out);
+        if (p->errors > errors)
             out = NULL;
-        }
     }
 
     return out;
 }
 
+/* Value of a numeric literal token */
+static void literal_value(struct lex_token *t, struct value *out)
+{
+    #ifndef NO_FLOAT_VALUES
+    if (t->type == LEX_FLOATING_POINT) {
+        value_init_f64(out, t->value.fp);
+        return;
+    }
+    #endif
+    #ifndef NO_64BIT_VALUES
+    if (t->type == LEX_UINTEGER) {
+        uintmax_t uint = (uintmax_t)t->value.integer;
+        if (uint != (uint32_t)uint) {
+            value_init_u64(out, uint);
+        } else {
+            value_init_u32(out, uint);
+        }
+    } else {
+        intmax_t sint = t->value.integer;
+        if ((uintmax_t)sint != (uint32_t)sint) {
+            value_init_s64(out, sint);
+        } else {
+            value_init_s32(out, sint);
+        }
+    }
+    #else
+    if (t->type == LEX_UINTEGER) {
+        value_init_u32(out, (uint32_t)t->value.integer);
+    } else {
+        value_init_s32(out, (int32_t)t->value.integer);
+    }
+    #endif
+}
+
+static int is_literal(enum lex_token_type type)
+{
+    #ifndef NO_FLOAT_VALUES
+    if (type == LEX_FLOATING_POINT)
+        return 1;
+    #endif
+    return type == LEX_INTEGER || type == LEX_UINTEGER;
+}
+
+int parse_normalize(const char *in, char *out, size_t size,
+                    struct value *params, size_t *params_size,
+                    size_t capacity)
+{
+    struct lex_token token;
+    const char *pin;
+    size_t i, n, len;
+
+    /* Number the literals after the largest parameter of the text */
+    n = *params_size;
+    for (pin = in; lexer(&pin, &token) && token.type != LEX_EOL; ) {
+        if (token.type == LEX_PARAMETER) {
+            const char *digit = token.value.identifier.name + 1;
+            const char *end = digit + token.value.identifier.len - 1;
+            for (i = 0; digit < end && i <= capacity; digit++)
+                i = 10*i + (*digit - '0');
+            if (n < i) n = i;
+        }
+    }
+    if (token.type != LEX_EOL)
+        return -1;
+    if (n > capacity)
+        return 0;
+    for (i = *params_size; i < n; i++)
+        params[i].type = 0;
+
+    for (len = 0, pin = in; lexer(&pin, &token) && token.type != LEX_EOL; ) {
+        if (len) out[len++] = ' ';
+        if (len >= size)
+            return 0;
+        if (is_literal(token.type)) {
+            if (n == capacity)
+                return 0;
+            literal_value(&token, &params[n++]);
+            len += snprintf(&out[len], size - len, "$%lu", (unsigned long)n);
+        } else {
+            len += lex_token_to_string(&token, &out[len], size - len);
+        }
+        if (len >= size)
+            return 0;
+    }
+    out[len] = '\0';
+    *params_size = n;
+    return 1;
+}
+
+int parse_substitute(const char *in, char *out, size_t size,
+                     const char *const *names, const char *const *texts,
+                     size_t n)
+{
+    struct lex_token token;
+    const char *pin, *start, *text;
+    size_t i, len, text_len;
+
+    for (len = 0, pin = in; ; len += text_len) {
+        start = pin;
+        if (!lexer(&pin, &token))
+            return -1;
+        if (token.type == LEX_EOL)
+            break;
+        text = NULL;
+        if (token.type == LEX_IDENTIFIER) {
+            const char *name = token.value.identifier.name;
+            size_t name_len = token.value.identifier.len;
+            for (i = 0; i < n; i++) {
+                if (!strncmp(names[i], name, name_len) && !names[i][name_len])
+                    break;
+            }
+            if (i < n && texts[i])
+                text = texts[i];
+        }
+        if (text) {
+            text_len = strlen(text);
+        } else {
+            text = start;
+            text_len = pin - start;
+        }
+        if (len + text_len >= size)
+            return 0;
+        memcpy(&out[len], text, text_len);
+    }
+    out[len] = '\0';
+    return 1;
+}
+
 #define INT UMAX
 #ifndef NO_FLOAT_VALUES
 #define INTFPU FMAX
@@ -158,7 +283,7 @@ static struct ast *ast_binary_try_new(struct parser *p, enum ast_type node_type,
     struct ast_cast *cast, **pcast;
     struct ast **pother;
     if (!left || !right)
-        goto delete_operands;
+        return NULL;
 
     if ((left->value_type & PTR) && (right->value_type & PTR)) {
         if ((node_type == AST_SUB && left->value_type == right->value_type)
@@ -166,14 +291,12 @@ static struct ast *ast_binary_try_new(struct parser *p, enum ast_type node_type,
             struct ast *root;
             struct ast *l = ((struct ast_unary *)left)->child;
             struct ast *r = ((struct ast_unary *)right)->child;
-            if ((root = ast_binary_new(node_type, l, r))) {
+            if ((root = ast_binary_new(p->arena, node_type, l, r))) {
                 if (ast_is_compare(root)) {
                     root->value_type = S32;
                 } else {
                     root->value_type = p->addr_type ^ (S8 ^ U8);
                 }
-                free(left);
-                free(right);
                 return root;
             }
             errfmt = "out-of-memory for '%s' with pointer operands";
@@ -202,32 +325,32 @@ static struct ast *ast_binary_try_new(struct parser *p, enum ast_type node_type,
                 goto print_error;
             }
             if (!ast_type_is_conditional(node_type))
-                *pother = promote_type(*pother, p->addr_type);
+                *pother = promote_type(p, *pother, p->addr_type);
             *(struct ast **)pcast = cast->tree.child;
         } else {
-            left = promote_type(left, right->value_type);
-            right = promote_type(right, left->value_type);
+            left = promote_type(p, left, right->value_type);
+            right = promote_type(p, right, left->value_type);
             if (left) {
                 if (value_type_is_int(left->value_type))
-                    left = promote_type(left, S32);
+                    left = promote_type(p, left, S32);
                 #ifndef NO_FLOAT_VALUES
                 else if (value_type_is_fpu(left->value_type))
-                    left = promote_type(left, F64);
+                    left = promote_type(p, left, F64);
                 #endif
             }
             if (right) {
                 if (value_type_is_int(right->value_type))
-                    right = promote_type(right, S32);
+                    right = promote_type(p, right, S32);
                 #ifndef NO_FLOAT_VALUES
                 else if (value_type_is_fpu(right->value_type))
-                    right = promote_type(right, F64);
+                    right = promote_type(p, right, F64);
                 #endif
             }
         }
 
         if (left && right) {
             struct ast *root;
-            if ((root = ast_binary_new(node_type, left, right))) {
+            if ((root = ast_binary_new(p->arena, node_type, left, right))) {
                 if (ast_is_compare(root)) {
                     root->value_type = S32;
                 } else {
@@ -250,10 +373,6 @@ static struct ast *ast_binary_try_new(struct parser *p, enum ast_type node_type,
 
 print_error:
     parse_error(p, errfmt, lex_token_type_string[ast_to_lex_type(node_type)]);
-
-delete_operands:
-    if (left) ast_delete(left);
-    if (right) ast_delete(right);
     return NULL;
 }
 
@@ -293,11 +412,104 @@ static struct ast *equality_expression(struct parser *p)
     return root;
 }
 
+/*
+ * Set membership `x in {e1, e2, ...}` with operands promoted to a common type.
+ */
+/*
+ * Set elements {e1, e2, ...} parsed into a malloc'd array.
+ */
+static int set_elements(struct parser *p, struct ast ***out, size_t *count)
+{
+    struct ast **elements = NULL;
+    size_t size = 0, capacity = 0;
+
+    if (!expect(p, LEX_LEFT_BRACE))
+        return 0;
+    while (p->symbol->type != LEX_RIGHT_BRACE) {
+        struct ast *element;
+        if (size && !expect(p, LEX_COMMA))
+            goto fail;
+        if (!(element = or_expression(p)))
+            goto fail;
+        if (size == capacity) {
+            struct ast **tmp;
+            capacity = capacity ? 2*capacity : 16;
+            if (!(tmp = realloc(elements, capacity * sizeof(struct ast *)))) {
+                parse_error(p, "out-of-memory for set elements");
+                goto fail;
+            }
+            elements = tmp;
+        }
+        elements[size++] = element;
+    }
+    accept(p, LEX_RIGHT_BRACE);
+
+    *out = elements;
+    *count = size;
+    return 1;
+
+fail:
+    free(elements);
+    return 0;
+}
+
+static struct ast *set_membership(struct parser *p, struct ast *x)
+{
+    struct ast *root, **elements;
+    size_t i, size;
+    enum value_type type = x->value_type;
+
+    if (!set_elements(p, &elements, &size))
+        return NULL;
+    for (i = 0; i < size; i++)
+        type = HIGHER_TYPE(type, elements[i]->value_type);
+
+    if (type & PTR) {
+        parse_error(p, "pointer operands unsupported by 'in'");
+        goto fail;
+    }
+    if (value_type_is_int(type)) {
+        type = HIGHER_TYPE(type, S32);
+    #ifndef NO_FLOAT_VALUES
+    } else {
+        type = F64;
+    #endif
+    }
+    x = promote_type(p, x, type);
+    for (i = 0; x && i < size; i++) {
+        if (!(elements[i] = promote_type(p, elements[i], type)))
+            x = NULL;
+    }
+    if (!x || !(root = ast_in_new(p->arena, x, elements, size))) {
+        parse_error(p, "out-of-memory for AST node 'in'");
+        goto fail;
+    }
+    free(elements);
+    return root;
+
+fail:
+    free(elements);
+    return NULL;
+}
+
+static int accept_in(struct parser *p)
+{
+    struct lex_token *t = p->symbol;
+    if (t->type == LEX_IDENTIFIER && t->value.identifier.len == 2
+            && !memcmp(t->value.identifier.name, "in", 2)) {
+        accept(p, LEX_IDENTIFIER);
+        return 1;
+    }
+    return 0;
+}
+
 static struct ast *relational_expression(struct parser *p)
 {
     struct ast *root = or_expression(p);
 
-    if (root && (accept(p, LEX_LT) || accept(p, LEX_GT)
+    if (root && accept_in(p)) {
+        root = set_membership(p, root);
+    } else if (root && (accept(p, LEX_LT) || accept(p, LEX_GT)
               || accept(p, LEX_LE) || accept(p, LEX_GE))) {
         enum ast_type type = lex_to_ast_type(p->accepted->type);
         struct ast *left = root;
@@ -395,27 +607,22 @@ static struct ast *cast_expression(struct parser *p)
     int ptrs;
     enum value_type type;
     if (accept_typecast(p, &type, &ptrs)) {
-        struct ast *child, *gchild;
+        struct ast *child;
         if (ptrs > 1) {
             parse_error(p, "multi-level pointers unimplemented");
             return NULL;
         }
         if (!(child = cast_expression(p)))
             return NULL;
-        if (child->value_type & PTR) {
-            gchild = ((struct ast_unary *)child)->child;
-            free(child);
-            child = gchild;
-        }
+        if (child->value_type & PTR)
+            child = ((struct ast_unary *)child)->child;
         if (ptrs) {
-            if (!(child = promote_type(child, p->addr_type)))
+            if (!(child = promote_type(p, child, p->addr_type)))
                 parse_error(p, "out-of-memory for pointer cast");
             type |= PTR;
         }
-        if (child && !(child = ast_cast_new(type, (gchild = child)))) {
+        if (child && !(child = ast_cast_new(p->arena, type, child)))
             parse_error(p, "out-of-memory for cast");
-            ast_delete(gchild);
-        }
         return child;
     }
     return unary_expression(p);
@@ -438,10 +645,10 @@ static struct ast *unary_expression(struct parser *p)
             if (p->target) {
                 enum value_type type = child->value_type ^ PTR;
                 struct ast *gchild = ((struct ast_unary *)child)->child;
-                if ((root = ast_deref_new(gchild, type, p->target))) {
+                root = ast_deref_new(p->arena, gchild, type, p->target);
+                if (root) {
                     root->value_type = child->value_type & ~PTR;
                     p->has_deref |= 1;
-                    free(child);
                     return root;
                 }
                 parse_error(p, "out-of-memory for AST_DEREF node");
@@ -451,7 +658,6 @@ static struct ast *unary_expression(struct parser *p)
         } else {
             parse_error(p, "invalid non-pointer operand type for unary '*'");
         }
-        ast_delete(child);
         return NULL;
     }
 
@@ -467,13 +673,11 @@ static struct ast *unary_expression(struct parser *p)
         if (child->value_type & PTR) {
             if (child->node_type == AST_CAST) {
                 struct ast **pgchild = &((struct ast_unary *)child)->child;
-                if ((root = ast_unary_new(type, *pgchild))) {
+                if ((root = ast_unary_new(p->arena, type, *pgchild))) {
                     root->value_type = (*pgchild)->value_type;
                     if (type != AST_NOT) {
                         *pgchild = root;
                         root = child;
-                    } else {
-                        free(child);
                     }
                     return root;
                 }
@@ -482,24 +686,21 @@ static struct ast *unary_expression(struct parser *p)
                 parse_error(p, "unexpected pointer from non-cast node");
                 root = NULL;
             }
-            ast_delete(child);
             return root;
         }
 
         if (child->value_type <= ((type == AST_NEG) ? INTFPU : INT)) {
-            if ((child = promote_type(child, S32))) {
-                if ((root = ast_unary_new(type, child))) {
+            if ((child = promote_type(p, child, S32))) {
+                if ((root = ast_unary_new(p->arena, type, child))) {
                     root->value_type = child->value_type;
                     return root;
                 }
                 errfmt = "out-of-memory for AST node '%s'";
-                ast_delete(child);
             } else {
                 errfmt = "out-of-memory for implicit cast for '%s'";
             }
         } else {
             errfmt = "invalid operand type for '%s'";
-            ast_delete(child);
         }
 
         op = lex_token_type_string[ast_to_lex_type(type)];
@@ -512,69 +713,328 @@ static struct ast *unary_expression(struct parser *p)
     return root;
 }
 
+/*
+ * Address argument (an integer or a pointer) of a builtin function call.
+ */
+static struct ast *address_argument(struct parser *p, const char *name,
+                                    size_t len)
+{
+    struct ast *arg;
+    if (!expect(p, LEX_LEFT_PARENTHESIS) || !(arg = expression(p)))
+        return NULL;
+    if (arg->value_type & PTR)
+        arg = ((struct ast_unary *)arg)->child;
+    if (!value_type_is_int(arg->value_type)) {
+        parse_error(p, "invalid address operand type for %.*s()",
+                    (int)len, name);
+        return NULL;
+    }
+    if (arg->value_type != p->addr_type) {
+        struct ast *cast;
+        if (!(cast = ast_cast_new(p->arena, p->addr_type, arg))) {
+            parse_error(p, "out-of-memory for address cast");
+            return NULL;
+        }
+        arg = cast;
+    }
+    return arg;
+}
+
+/*
+ * Builtin function call isptr(addr) or inregion(addr, "path").
+ */
+static struct ast *builtin_call(struct parser *p, const char *name, size_t len)
+{
+    struct ast *arg, *root;
+    struct region_table *table;
+    const char *pattern = NULL;
+    size_t pattern_len = 0;
+
+    if (!p->target || !(table = p->target->regions(p->target))) {
+        parse_error(p, "%.*s() requires memory regions of a target",
+                    (int)len, name);
+        return NULL;
+    }
+
+    if (!(arg = address_argument(p, name, len)))
+        return NULL;
+
+    if (len == 8) {
+        if (!expect(p, LEX_COMMA) || !expect(p, LEX_STRING))
+            return NULL;
+        pattern = p->accepted->value.string.str;
+        pattern_len = p->accepted->value.string.len;
+    }
+    if (!expect(p, LEX_RIGHT_PARENTHESIS))
+        return NULL;
+
+    root = pattern ? ast_inregion_new(p->arena, arg, table,
+                                      pattern, pattern_len)
+                   : ast_isptr_new(p->arena, arg, table);
+    if (!root)
+        parse_error(p, "out-of-memory for AST node '%.*s'", (int)len, name);
+    return root;
+}
+
+/*
+ * Byte pattern "48 8b ?? 4? 89" of hexadecimal bytes, where ?? (or ?) is any
+ * byte and ? in place of a hexadecimal digit is any nibble. Returns the size
+ * of the pattern (or 0 if invalid).
+ */
+static size_t byte_pattern(const char *str, size_t len,
+                           unsigned char *pattern, unsigned char *mask)
+{
+    size_t i, k, n;
+
+    for (i = n = 0; i < len; n++) {
+        while (i < len && isspace(str[i])) i++;
+        if (i == len)
+            break;
+        if (n == AST_BYTES_MAX)
+            return 0;
+        if (str[i] == '?' && (i+1 == len || isspace(str[i+1]))) {
+            pattern[n] = mask[n] = 0;
+            i++;
+            continue;
+        }
+        if (i+1 == len)
+            return 0;
+        pattern[n] = mask[n] = 0;
+        for (k = i + 2; i < k; i++) {
+            int c = tolower(str[i]);
+            pattern[n] <<= 4;
+            mask[n] <<= 4;
+            if (c >= '0' && c <= '9') {
+                pattern[n] |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                pattern[n] |= c - 'a' + 10;
+            } else if (c != '?') {
+                return 0;
+            }
+            if (c != '?')
+                mask[n] |= 0x0f;
+        }
+    }
+    return n;
+}
+
+/*
+ * Byte pattern match bytes(addr, "48 8b ?? 4? 89").
+ */
+static struct ast *bytes_call(struct parser *p)
+{
+    unsigned char pattern[AST_BYTES_MAX], mask[AST_BYTES_MAX];
+    struct ast *arg, *root;
+    size_t size;
+
+    if (!p->target) {
+        parse_error(p, "bytes() requires a target");
+        return NULL;
+    }
+    if (!(arg = address_argument(p, "bytes", 5)))
+        return NULL;
+    if (!expect(p, LEX_COMMA) || !expect(p, LEX_STRING))
+        return NULL;
+    size = byte_pattern(p->accepted->value.string.str,
+                        p->accepted->value.string.len, pattern, mask);
+    if (!size) {
+        parse_error(p, "invalid byte pattern (of at most %d bytes)",
+                    AST_BYTES_MAX);
+        return NULL;
+    }
+    if (!expect(p, LEX_RIGHT_PARENTHESIS))
+        return NULL;
+
+    root = ast_bytes_new(p->arena, arg, p->target, pattern, mask, size);
+    if (!root)
+        parse_error(p, "out-of-memory for AST node 'bytes'");
+    p->has_deref |= 1;
+    return root;
+}
+
+static int is_builtin(const char *name, size_t len)
+{
+    return (len == 5 && !memcmp(name, "isptr", 5))
+        || (len == 8 && !memcmp(name, "inregion", 8));
+}
+
+#ifndef NO_FLOAT_VALUES
+/*
+ * Approximate comparison approx(x, c, eps), ulps(x, c, n) or rounds(x, c, d)
+ * of a floating-point x (integer x is converted to f64).
+ */
+static struct ast *near_call(struct parser *p, enum value_near mode,
+                             const char *name, size_t len)
+{
+    struct ast *args[3], *root;
+    int i;
+
+    if (!expect(p, LEX_LEFT_PARENTHESIS))
+        return NULL;
+    for (i = 0; i < 3; i++) {
+        if ((i && !expect(p, LEX_COMMA)) || !(args[i] = expression(p)))
+            return NULL;
+        if (args[i]->value_type & PTR) {
+            parse_error(p, "invalid pointer operand for %.*s()",
+                        (int)len, name);
+            return NULL;
+        }
+    }
+    if (!expect(p, LEX_RIGHT_PARENTHESIS))
+        return NULL;
+
+    if (!value_type_is_fpu(args[0]->value_type)) {
+        if (!(args[0] = ast_cast_new(p->arena, F64, args[0]))) {
+            parse_error(p, "out-of-memory for AST cast node");
+            return NULL;
+        }
+    }
+    if (!(root = ast_near_new(p->arena, args[0], args[1], args[2], mode)))
+        parse_error(p, "out-of-memory for AST node '%.*s'", (int)len, name);
+    return root;
+}
+
+/*
+ * Proximity test within(p, {c1, ..., cN}, r) or within(p, {...}, r, stride)
+ * of N values pointed by a f32* or f64* pointer p. The stride of the values
+ * defaults to their size.
+ */
+static struct ast *within_call(struct parser *p)
+{
+    struct ast *ptr, *addr, *radius, *stride, *root, **elements;
+    enum value_type type;
+    size_t i, size;
+
+    if (!p->target) {
+        parse_error(p, "within() requires a target");
+        return NULL;
+    }
+    if (!expect(p, LEX_LEFT_PARENTHESIS) || !(ptr = expression(p)))
+        return NULL;
+    type = ptr->value_type & ~PTR;
+    if (!(ptr->value_type & PTR) || (type != F32 && type != F64)) {
+        parse_error(p, "within() requires a f32* or f64* pointer");
+        return NULL;
+    }
+    addr = ((struct ast_unary *)ptr)->child;
+    if (addr->value_type != p->addr_type) {
+        if (!(addr = ast_cast_new(p->arena, p->addr_type, addr))) {
+            parse_error(p, "out-of-memory for address cast");
+            return NULL;
+        }
+    }
+
+    if (!expect(p, LEX_COMMA) || !set_elements(p, &elements, &size))
+        return NULL;
+    root = NULL;
+    if (!size) {
+        parse_error(p, "within() requires a non-empty point");
+        goto done;
+    }
+    for (i = 0; i < size; i++) {
+        if (elements[i]->value_type & PTR) {
+            parse_error(p, "invalid pointer coordinate for within()");
+            goto done;
+        }
+    }
+    if (!expect(p, LEX_COMMA) || !(radius = expression(p)))
+        goto done;
+    if (accept(p, LEX_COMMA)) {
+        if (!(stride = expression(p)))
+            goto done;
+    } else {
+        struct value value;
+        value_init_umax(&value, value_type_sizeof(type));
+        if (!(stride = ast_value_new(p->arena, &value))) {
+            parse_error(p, "out-of-memory for AST value node");
+            goto done;
+        }
+    }
+    if (!expect(p, LEX_RIGHT_PARENTHESIS))
+        goto done;
+    if ((radius->value_type & PTR) || !value_type_is_int(stride->value_type)) {
+        parse_error(p, "invalid radius or stride operand for within()");
+        goto done;
+    }
+
+    root = ast_within_new(p->arena, addr, p->target, type,
+                          elements, size, radius, stride);
+    if (!root)
+        parse_error(p, "out-of-memory for AST node 'within'");
+    p->has_deref |= 1;
+done:
+    free(elements);
+    return root;
+}
+
+/* Approximate comparison builtin (VALUE_NEAR_* + 1) or 0 */
+static int is_near_builtin(const char *name, size_t len)
+{
+    if (len == 6 && !memcmp(name, "approx", 6))
+        return VALUE_NEAR_ABS + 1;
+    if (len == 4 && !memcmp(name, "ulps", 4))
+        return VALUE_NEAR_ULPS + 1;
+    if (len == 6 && !memcmp(name, "rounds", 6))
+        return VALUE_NEAR_ROUND + 1;
+    return 0;
+}
+#endif
+
 static struct ast *factor(struct parser *p)
 {
     struct ast *root;
+#ifndef NO_FLOAT_VALUES
+    int near;
+#endif
 
-    if (accept(p, LEX_IDENTIFIER)) {
+    if (accept(p, LEX_IDENTIFIER) || accept(p, LEX_PARAMETER)) {
         size_t sym;
         const char *name = p->accepted->value.identifier.name;
         size_t len = p->accepted->value.identifier.len;
-        if (p->symtab && (sym = symbol_table_lookup(p->symtab, name, len))) {
+        if (p->symbol->type == LEX_LEFT_PARENTHESIS && is_builtin(name, len)) {
+            root = builtin_call(p, name, len);
+        } else if (p->symbol->type == LEX_LEFT_PARENTHESIS
+                   && len == 5 && !memcmp(name, "bytes", 5)) {
+            root = bytes_call(p);
+#ifndef NO_FLOAT_VALUES
+        } else if (p->symbol->type == LEX_LEFT_PARENTHESIS
+                   && (near = is_near_builtin(name, len))) {
+            root = near_call(p, (enum value_near)(near - 1), name, len);
+        } else if (p->symbol->type == LEX_LEFT_PARENTHESIS
+                   && len == 6 && !memcmp(name, "within", 6)) {
+            root = within_call(p);
+#endif
+        } else if (p->symtab
+                   && (sym = symbol_table_lookup(p->symtab, name, len))) {
             struct symbol *symbol = p->symtab->symbols[sym];
             if (symbol->type & PTR) {
                 size_t size = value_type_sizeof(p->addr_type);
-                if ((root = ast_var_new(p->symtab, sym, size))) {
+                if ((root = ast_var_new(p->arena, p->symtab, sym, size))) {
                     struct ast *cast;
                     root->value_type = p->addr_type;
-                    if ((cast = ast_cast_new(symbol->type, root))) {
-                        root = cast;
-                    } else {
-                        ast_delete(root);
-                        root = NULL;
-                    }
+                    cast = ast_cast_new(p->arena, symbol->type, root);
+                    root = cast;
                 }
             } else {
-                root = ast_var_new(p->symtab, sym, 0);
+                root = ast_var_new(p->arena, p->symtab, sym, 0);
             }
             if (!root)
                 parse_error(p, "out-of-memory for AST variable node");
+        } else if (p->accepted->type == LEX_PARAMETER) {
+            parse_error(p, "unbound parameter '%.*s'", (int)len, name);
+            root = NULL;
         } else {
             parse_error(p, "unknown identifier '%.*s'", (int)len, name);
             root = NULL;
         }
-    } else if (accept(p, LEX_INTEGER)) {
-        struct value value;
-        #ifndef NO_64BIT_VALUES
-        intmax_t sint = p->accepted->value.integer;
-        if ((uintmax_t)sint != (uint32_t)sint) {
-            value_init_s64(&value, sint);
-        } else {
-            value_init_s32(&value, sint);
-        }
-        #else
-        value_init_s32(&value, (int32_t)p->accepted->value.integer);
-        #endif
-        root = ast_value_new(&value);
-    } else if (accept(p, LEX_UINTEGER)) {
-        struct value value;
-        #ifndef NO_64BIT_VALUES
-        uintmax_t uint = (uintmax_t)p->accepted->value.integer;
-        if (uint != (uint32_t)uint) {
-            value_init_u64(&value, uint);
-        } else {
-            value_init_u32(&value, uint);
-        }
-        #else
-        value_init_u32(&value, (uint32_t)p->accepted->value.integer);
-        #endif
-        root = ast_value_new(&value);
+    } else if (accept(p, LEX_INTEGER) || accept(p, LEX_UINTEGER)
     #ifndef NO_FLOAT_VALUES
-    } else if (accept(p, LEX_FLOATING_POINT)) {
-        struct value value;
-        value_init_f64(&value, p->accepted->value.fp);
-        root = ast_value_new(&value);
+               || accept(p, LEX_FLOATING_POINT)
     #endif
+               ) {
+        struct value value;
+        literal_value(p->accepted, &value);
+        root = ast_value_new(p->arena, &value);
     } else if (accept(p, LEX_LEFT_PARENTHESIS)) {
         root = expression(p);
         expect(p, LEX_RIGHT_PARENTHESIS);
@@ -17,6 +17,9 @@ struct parser {
     struct target *target;
     int has_deref;
 
+    /* Arena of the AST nodes (must be set before parsing) */
+    struct ast_arena *arena;
+
     struct lex_token *symbol;   /* symbol being processed */
     struct lex_token *accepted; /* last accepted symbol */
     struct lex_token tokens[2]; /* symbol and accepted fields point here */
@@ -32,10 +35,37 @@ void parser_init(struct parser *parser);
 /*
  * Parse an expression using symbol table to produce an abstract syntax tree.
  *
- * Returns the number of errors, i.e., zero if successful. Upon return `*pout`,
- * if non-NULL, receives a pointer to the parsed AST (or NULL on parse error).
- * The received AST pointer `*pout` must be deleted with ast_delete().
+ * Returns the parsed AST allocated from the arena of the parser (or NULL on
+ * parse error). The AST is freed by resetting the arena.
  */
 struct ast *parse_expression(struct parser *p, const char *in);
 
+/*
+ * Normalize expression `in` for caching the parsed AST of it.
+ *
+ * The tokens of `in` are written to buffer `out` of `size` bytes separated by
+ * single spaces, and numeric literals are replaced by parameters $n+1, $n+2,
+ * etc., where n is the larger of *params_size and the largest parameter of
+ * `in`. Values of the literals are stored to params[n], params[n+1], ... (up
+ * to `capacity` parameters) and *params_size is updated. Parameters missing
+ * below n get type 0.
+ *
+ * Returns 1 on success, 0 if `out` or `params` is too small and -1 on lexical
+ * errors (which are reported).
+ */
+int parse_normalize(const char *in, char *out, size_t size,
+                    struct value *params, size_t *params_size,
+                    size_t capacity);
+
+/*
+ * Substitute identifiers names[0], ..., names[n-1] of expression `in` by the
+ * texts texts[0], ..., texts[n-1] (or keep them if NULL). The rest of `in`
+ * is copied verbatim to buffer `out` of `size` bytes.
+ *
+ * Returns 1 on success, 0 if `out` is too small and -1 on lexical errors.
+ */
+int parse_substitute(const char *in, char *out, size_t size,
+                     const char *const *names, const char *const *texts,
+                     size_t n);
+
 #endif
@@ -9,6 +9,10 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <sys/user.h>
+#endif
+
 int ptrace_attach(pid_t pid)
 {
     int status;
@@ -57,6 +61,215 @@ int ptrace_continue(pid_t pid)
     return 1;
 }
 
+#if defined(__x86_64__)
+# define REG_IP(regs) ((regs).rip)
+# define REG_AX(regs) ((regs).rax)
+# define REG_ORIG_AX(regs) ((regs).orig_rax)
+# define REG_ARG0(regs) ((regs).rdi)
+# define REG_ARG1(regs) ((regs).rsi)
+# define REG_ARG2(regs) ((regs).rdx)
+# define REG_ARG3(regs) ((regs).r10)
+# define SYSCALL_INSN "\x0F\x05" /* syscall */
+# define SYSCALL_CLONE 56
+# define SYSCALL_WAIT4 61
+#elif defined(__i386__)
+# define REG_IP(regs) ((regs).eip)
+# define REG_AX(regs) ((regs).eax)
+# define REG_ORIG_AX(regs) ((regs).orig_eax)
+# define REG_ARG0(regs) ((regs).ebx)
+# define REG_ARG1(regs) ((regs).ecx)
+# define REG_ARG2(regs) ((regs).edx)
+# define REG_ARG3(regs) ((regs).esi)
+# define SYSCALL_INSN "\xCD\x80" /* int $0x80 */
+# define SYSCALL_CLONE 120
+# define SYSCALL_WAIT4 114
+#endif
+
+#ifdef SYSCALL_INSN
+/*
+ * Find a system call instruction in executable memory of the tracee. The
+ * vDSO is searched first, other executable mappings only if it is missing.
+ */
+static void *syscall_insn(pid_t pid)
+{
+    char path[64], line[1024], perms[5];
+    unsigned char buf[4096];
+    unsigned long start, end, addr;
+    size_t i, len;
+    void *insn = NULL;
+    int pass, bol;
+    FILE *maps;
+
+    sprintf(path, "/proc/%lu/maps", (unsigned long)pid);
+    if (!(maps = fopen(path, "r"))) {
+        perror("fopen(maps)");
+        return NULL;
+    }
+    for (pass = 0; !insn && pass < 2; pass++) {
+        rewind(maps);
+        for (bol = 1; !insn && fgets(line, sizeof(line), maps);
+                bol = !!strchr(line, '\n')) {
+            if (!bol || sscanf(line, "%lx-%lx %4s", &start, &end, perms) != 3
+                    || perms[2] != 'x' || !pass != !!strstr(line, "[vdso]"))
+                continue;
+            for (addr = start; !insn && end - addr >= 2; addr += len - 1) {
+                len = end - addr < sizeof(buf) ? end - addr : sizeof(buf);
+                if (!ptrace_read(pid, (void *)addr, buf, len))
+                    break;
+                for (i = 0; i < len - 1; i++) {
+                    if (buf[i] == (unsigned char)SYSCALL_INSN[0]
+                            && buf[i+1] == (unsigned char)SYSCALL_INSN[1]) {
+                        insn = (void *)(addr + i);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    fclose(maps);
+
+    if (!insn)
+        fputs("ptrace(SYSCALL): no syscall instruction found\n", stderr);
+    return insn;
+}
+
+/*
+ * Make a stopped tracee execute system call nr with arguments args[0..3].
+ * The tracee code is left untouched by jumping to an existing instruction.
+ * Stores the return value in *ret and the message of a ptrace event stop
+ * in *msg (if not NULL). Signals received meanwhile are re-sent afterwards.
+ */
+static int ptrace_syscall(pid_t pid, long nr, const long args[4], long *ret,
+                          unsigned long *msg)
+{
+    struct user_regs_struct regs, saved;
+    sigset_t pending;
+    int status, sig, rc = 0;
+    void *ip;
+
+    if (!(ip = syscall_insn(pid)))
+        return 0;
+    if (ptrace(PTRACE_GETREGS, pid, NULL, &saved) == -1) {
+        perror("ptrace(GETREGS)");
+        return 0;
+    }
+
+    /* Disable syscall restarting by setting orig_ax to -1 */
+    regs = saved;
+    REG_IP(regs) = (unsigned long)ip;
+    REG_AX(regs) = nr;
+    REG_ORIG_AX(regs) = -1;
+    REG_ARG0(regs) = args[0];
+    REG_ARG1(regs) = args[1];
+    REG_ARG2(regs) = args[2];
+    REG_ARG3(regs) = args[3];
+    if (ptrace(PTRACE_SETREGS, pid, NULL, &regs) == -1) {
+        perror("ptrace(SETREGS)");
+        return 0;
+    }
+
+    /* Step over the syscall instruction while deferring signals */
+    sigemptyset(&pending);
+    while (ptrace(PTRACE_SINGLESTEP, pid, NULL, NULL) != -1) {
+        if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status)) {
+            perror("waitpid(SYSCALL)");
+            break;
+        }
+        if (status >> 16) {
+            if (msg && ptrace(PTRACE_GETEVENTMSG, pid, NULL, msg) == -1)
+                perror("ptrace(GETEVENTMSG)");
+        } else if (WSTOPSIG(status) == SIGTRAP) {
+            if (ptrace(PTRACE_GETREGS, pid, NULL, &regs) != -1) {
+                *ret = (long)REG_AX(regs);
+                rc = 1;
+            } else perror("ptrace(GETREGS)");
+            break;
+        } else {
+            sigaddset(&pending, WSTOPSIG(status));
+        }
+    }
+
+    if (ptrace(PTRACE_SETREGS, pid, NULL, &saved) == -1) {
+        perror("ptrace(SETREGS)");
+        rc = 0;
+    }
+    for (sig = 1; sig < NSIG; sig++) {
+        if (sigismember(&pending, sig) == 1)
+            kill(pid, sig);
+    }
+    return rc;
+}
+
+pid_t ptrace_fork(pid_t pid)
+{
+    static const long args[4] = { 0, 0, 0, 0 };
+    unsigned long msg = 0;
+    long ret = -1;
+    int status;
+    pid_t child;
+
+    /* clone(2) with no exit signal spares the tracee a SIGCHLD */
+    if (ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)PTRACE_O_TRACECLONE)) {
+        perror("ptrace(SETOPTIONS)");
+        return 0;
+    }
+    if (!ptrace_syscall(pid, SYSCALL_CLONE, args, &ret, &msg) || ret < 0)
+        msg = 0;
+    ptrace(PTRACE_SETOPTIONS, pid, NULL, NULL);
+
+    if ((child = (pid_t)msg)) {
+        if (waitpid(child, &status, __WALL) == -1 || !WIFSTOPPED(status)) {
+            perror("waitpid(CLONE)");
+            ptrace_reap(pid, child);
+            child = 0;
+        }
+    } else if (ret > 0) {
+        fputs("ptrace(CLONE): untraced child killed\n", stderr);
+        kill((pid_t)ret, SIGKILL);
+        ptrace_reap(pid, (pid_t)ret);
+    }
+    return child;
+}
+
+int ptrace_reap(pid_t pid, pid_t child)
+{
+    long args[4], ret = -1;
+    int killed = ptrace_kill(child);
+    args[0] = child;
+    args[1] = 0;
+    args[2] = WNOHANG | __WALL;
+    args[3] = 0;
+    if (!ptrace_syscall(pid, SYSCALL_WAIT4, args, &ret, NULL))
+        return 0;
+    return killed && (ret == child || ret == -ECHILD);
+}
+#else
+pid_t ptrace_fork(pid_t pid)
+{
+    fputs("ptrace(FORK): unsupported architecture\n", stderr);
+    return 0;
+}
+
+int ptrace_reap(pid_t pid, pid_t child)
+{
+    return ptrace_kill(child);
+}
+#endif
+
+int ptrace_kill(pid_t pid)
+{
+    int status;
+    if (kill(pid, SIGKILL) == -1) {
+        perror("ptrace(KILL)");
+        return 0;
+    }
+    while (waitpid(pid, &status, __WALL) != -1) {
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            return 1;
+    }
+    return errno == ECHILD;
+}
+
 int ptrace_read(pid_t pid, const void *addr, void *buf, size_t len)
 {
     int errnold = errno;
@@ -17,6 +17,24 @@ int ptrace_detach(pid_t pid);
 int ptrace_break(pid_t pid);
 int ptrace_continue(pid_t pid);
 
+/*
+ * Make a stopped tracee fork by injecting a clone(2) system call.
+ *
+ * The child is traced and stopped, so it serves as a frozen copy-on-write
+ * snapshot of the tracee memory. Returns child pid or 0 on an error.
+ */
+pid_t ptrace_fork(pid_t pid);
+
+/*
+ * Kill a child created by ptrace_fork() and make the stopped tracee reap it.
+ */
+int ptrace_reap(pid_t pid, pid_t child);
+
+/*
+ * Kill and reap a traced process.
+ */
+int ptrace_kill(pid_t pid);
+
 /*
  * Read & write data.
  */
@@ -5,6 +5,7 @@
 #include "hits.h"
 #include "line.h"
 #include "ptrace.h"
+#include "search.h"
 #include "target.h"
 
 #include <ctype.h>
@@ -74,6 +75,8 @@ int ramfuck_init(struct ramfuck *ctx)
     ctx->hits = NULL;
     ctx->undo = NULL;
     ctx->redo = NULL;
+    ctx->prepared = NULL;
+    ctx->compiled = NULL;
     return 1;
 }
 
@@ -90,6 +93,7 @@ void ramfuck_destroy(struct ramfuck *ctx)
             linereader_close(ctx->linereader);
             ctx->linereader = NULL;
         }
+        prepared_clear(ctx);
         if (ctx->target) {
             if (!ctx->breaks)
                 ctx->target->stop(ctx->target);
@@ -27,6 +27,9 @@ struct ramfuck {
     struct hits *hits;
     struct hits *undo;
     struct hits *redo;
+
+    struct prepared *prepared;
+    struct compiled *compiled;
 };
 
 #define ramfuck_dead(ctx) ((ctx)->state == DEAD)
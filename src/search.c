@@ -11,33 +11,1589 @@
 #include "target.h"
 #include "value.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-struct hits *search(struct ramfuck *ctx, enum value_type type,
-                    const char *expression)
+/*
+ * Maximum gap between two hits read in a single span when verifying hits.
+ */
+#define VERIFY_GAP_MAX 4096
+
+/*
+ * Maximum size of a chunk of a memory region read and scanned at once.
+ */
+#define SCAN_CHUNK_SIZE (1024*1024)
+
+/*
+ * Maximum number of value types searched or filtered in a single pass.
+ */
+#define SCAN_TYPES_MAX 16
+
+/*
+ * Number of pages in the direct-mapped page cache of a scan target.
+ */
+#define SCAN_CACHE_PAGES 64
+
+/*
+ * Number of compiled expressions cached.
+ */
+#define COMPILED_CACHE_SIZE 16
+
+/*
+ * Maximum length of the normalized text of a cached compiled expression.
+ */
+#define COMPILED_TEXT_MAX 1024
+
+/*
+ * Maximum number of parameters of a cached compiled expression.
+ */
+#define COMPILED_PARAMS_MAX 32
+
+/*
+ * Target seen by expressions of a search or filter (i.e., by dereferences).
+ *
+ * Reads of memory buffered by the scan are served from the buffer without a
+ * system call, and other reads from a direct-mapped page cache. The cache is
+ * valid as long as the target stays stopped.
+ */
+struct scan_target {
+    struct target base;
+    struct target *target;
+
+    /* Memory [start, start+size) buffered by the scan */
+    const char *buf;
+    addr_t start, size;
+
+    /* Cached pages (allocated on first use, tag 1 for an empty slot) */
+    char *cache;
+    addr_t tags[SCAN_CACHE_PAGES];
+};
+
+static int scan_target_detach(struct target *target)
+{
+    struct scan_target *st = (struct scan_target *)target;
+    free(st->cache);
+    st->cache = NULL;
+    return 1;
+}
+
+static int scan_target_stop(struct target *target)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->stop(real);
+}
+
+static int scan_target_run(struct target *target)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->run(real);
+}
+
+static struct target *scan_target_snapshot(struct target *target)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->snapshot(real);
+}
+
+static struct region_table *scan_target_regions(struct target *target)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->regions(real);
+}
+
+static int scan_target_pages(struct target *target, addr_t addr, size_t len,
+                             unsigned char *out)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->pages(real, addr, len, out);
+}
+
+static int scan_target_read(struct target *target, addr_t addr, void *buf,
+                            size_t len)
+{
+    char *out = buf;
+    size_t i, page_size;
+    struct scan_target *st = (struct scan_target *)target;
+
+    if (addr - st->start < st->size && len <= st->size - (addr - st->start)) {
+        memcpy(buf, &st->buf[addr - st->start], len);
+        return 1;
+    }
+
+    page_size = target_page_size();
+    if (!st->cache && !(st->cache = malloc(SCAN_CACHE_PAGES * page_size)))
+        return st->target->read(st->target, addr, buf, len);
+
+    while (len > 0) {
+        char *data;
+        addr_t page = addr - addr % page_size;
+        size_t n = (page + page_size - addr < len) ? page + page_size - addr
+                                                   : len;
+        i = (size_t)(page / page_size) % SCAN_CACHE_PAGES;
+        data = &st->cache[i * page_size];
+        if (st->tags[i] != page) {
+            if (!st->target->read(st->target, page, data, page_size)) {
+                st->tags[i] = 1;
+                return st->target->read(st->target, addr, out, len);
+            }
+            st->tags[i] = page;
+        }
+        memcpy(out, &data[addr - page], n);
+        addr += n;
+        out += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static int scan_target_write(struct target *target, addr_t addr, void *buf,
+                             size_t len)
+{
+    struct target *real = ((struct scan_target *)target)->target;
+    return real->write(real, addr, buf, len);
+}
+
+/* Drop buffered memory and cached pages of a scan target */
+static void scan_target_invalidate(struct scan_target *st)
+{
+    size_t i;
+    st->buf = NULL;
+    st->start = st->size = 0;
+    for (i = 0; i < SCAN_CACHE_PAGES; i++)
+        st->tags[i] = 1;
+}
+
+static void scan_target_init(struct scan_target *st, struct target *target)
+{
+    static const struct target scan_target_funcs = {
+        scan_target_detach,
+        scan_target_stop,
+        scan_target_run,
+        scan_target_snapshot,
+        scan_target_regions,
+        scan_target_pages,
+        scan_target_read,
+        scan_target_write
+    };
+    st->base = scan_target_funcs;
+    st->target = target;
+    st->cache = NULL;
+    scan_target_invalidate(st);
+}
+
+/* Set memory buffered by the scan */
+static void scan_target_view(struct scan_target *st, addr_t start,
+                             const char *buf, size_t size)
+{
+    st->buf = buf;
+    st->start = start;
+    st->size = size;
+}
+
+/*
+ * Store an address to the value of the `addr` symbol (of the address type).
+ */
+static void addr_store(struct value *addr, addr_t address)
+{
+#if ADDR_BITS == 64
+    if (addr->type == U32) {
+        addr->data.u32 = (uint32_t)address;
+        return;
+    }
+#endif
+    addr->data.addr = address;
+}
+
+/*
+ * Byte order reversal of 16-, 32- and 64-bit integers (which compilers turn
+ * into bswap/movbe instructions, or byte shuffles of vectorized loops).
+ */
+#define BSWAP16(x) ((uint16_t)((uint16_t)(x) >> 8 | (uint16_t)(x) << 8))
+#define BSWAP32(x) ((uint32_t)(BSWAP16((uint32_t)(x) >> 16)                 \
+                               | (uint32_t)BSWAP16(x) << 16))
+#define BSWAP64(x) ((uint64_t)(BSWAP32((uint64_t)(x) >> 32)                 \
+                               | (uint64_t)BSWAP32(x) << 32))
+
+/*
+ * Truth table of an expression depending only on a 8- or 16-bit integer
+ * value, i.e., a bit per each possible value telling whether the expression
+ * evaluates to true. The table is indexed by the value as stored in memory
+ * (so byte-swapped values are looked up without swapping). The value symbol
+ * of the expression must refer to `data`. Returns NULL for other types.
+ */
+static unsigned char *truth_table_new(struct ast *ast, enum value_type type,
+                                      union value_data *data)
+{
+    struct value value;
+    unsigned char *table;
+    size_t i, size;
+
+    switch (type) {
+    case S8: case U8: size = 256; break;
+    case S16: case U16: case BE16: size = 65536; break;
+    default: return NULL;
+    }
+
+    if (!(table = calloc(size / 8, 1)))
+        return NULL;
+    for (i = 0; i < size; i++) {
+        if (size == 256) {
+            data->u8 = (uint8_t)i;
+        } else {
+            data->u16 = (type == BE16) ? BSWAP16(i) : (uint16_t)i;
+        }
+        if (ast_evaluate(ast, &value) && value_is_nonzero(&value))
+            table[i / 8] |= 1 << (i % 8);
+    }
+    return table;
+}
+
+#define truth_table_test(table, x) ((table)[(x) / 8] & (1 << ((x) % 8)))
+
+/*
+ * Predicate kernels test values of aligned addresses in [from, to) of a
+ * buffer `buf` (starting from address `base`) against a predicate descriptor
+ * of ast_predicate() without evaluating the expression tree. Values are
+ * loaded by `load` (which reverses the byte order of byte-swapped types).
+ */
+typedef int (*predicate_kernel)(const struct ast_predicate *pred,
+                                struct hits *hits, enum value_type type,
+                                const char *buf, addr_t base,
+                                addr_t from, addr_t to, addr_t align);
+
+#define LOAD_NATIVE(x) (x)
+#define LOAD_BE16(x) ((int16_t)BSWAP16(x))
+#define LOAD_BE32(x) ((int32_t)BSWAP32(x))
+#define LOAD_BE64(x) ((int64_t)BSWAP64(x))
+
+#define PREDICATE_LOOP(T, load, cond)                                       \
+    for (address = from; address < to; address += align) {                  \
+        const char *data = &buf[address - base];                            \
+        T x;                                                                \
+        memcpy(&x, data, sizeof(T));                                        \
+        x = load(x);                                                        \
+        if ((cond) && !hits_add(hits, address, type,                        \
+                                (union value_data *)data)) {                \
+            return 0;                                                       \
+        }                                                                   \
+    }                                                                       \
+    break;
+
+#define PREDICATE_MEMBER(T, field)                                          \
+static int predicate_member_##field(const union value_data *set, size_t n, \
+                                    T x)                                    \
+{                                                                           \
+    size_t i, lo, hi;                                                       \
+    if (n <= AST_IN_LINEAR_MAX) {                                           \
+        int hit = 0;                                                        \
+        for (i = 0; i < n; i++)                                             \
+            hit |= set[i].field == x;                                       \
+        return hit;                                                         \
+    }                                                                       \
+    for (lo = 0, hi = n; lo < hi; ) {                                       \
+        i = lo + (hi - lo) / 2;                                             \
+        if (set[i].field < x) {                                             \
+            lo = i + 1;                                                     \
+        } else {                                                            \
+            hi = i;                                                         \
+        }                                                                   \
+    }                                                                       \
+    return lo < n && set[lo].field == x;                                    \
+}
+
+#define PREDICATE_KERNEL(T, field, name, load)                              \
+static int predicate_kernel_##name(const struct ast_predicate *pred,        \
+                                   struct hits *hits, enum value_type type, \
+                                   const char *buf, addr_t base,            \
+                                   addr_t from, addr_t to, addr_t align)    \
+{                                                                           \
+    const T lo = pred->lo.data.field, hi = pred->hi.data.field;             \
+    addr_t address;                                                         \
+    switch (pred->op) {                                                     \
+    case AST_EQ: PREDICATE_LOOP(T, load, x == lo)                           \
+    case AST_NEQ: PREDICATE_LOOP(T, load, x != lo)                          \
+    case AST_LT: PREDICATE_LOOP(T, load, x < lo)                            \
+    case AST_GT: PREDICATE_LOOP(T, load, x > lo)                            \
+    case AST_LE: PREDICATE_LOOP(T, load, x <= lo)                           \
+    case AST_GE: PREDICATE_LOOP(T, load, x >= lo)                           \
+    case AST_AND_COND: PREDICATE_LOOP(T, load, lo <= x && x <= hi)          \
+    case AST_IN: PREDICATE_LOOP(T, load, lo <= x && x <= hi                 \
+        && predicate_member_##field(pred->members, pred->size, x))          \
+    default: break;                                                         \
+    }                                                                       \
+    return 1;                                                               \
+}
+
+PREDICATE_MEMBER(int8_t, s8)
+PREDICATE_MEMBER(uint8_t, u8)
+PREDICATE_MEMBER(int16_t, s16)
+PREDICATE_MEMBER(uint16_t, u16)
+PREDICATE_MEMBER(int32_t, s32)
+PREDICATE_MEMBER(uint32_t, u32)
+#ifndef NO_64BIT_VALUES
+PREDICATE_MEMBER(int64_t, s64)
+PREDICATE_MEMBER(uint64_t, u64)
+#endif
+#ifndef NO_FLOAT_VALUES
+PREDICATE_MEMBER(float, f32)
+PREDICATE_MEMBER(double, f64)
+#endif
+
+PREDICATE_KERNEL(int8_t, s8, s8, LOAD_NATIVE)
+PREDICATE_KERNEL(uint8_t, u8, u8, LOAD_NATIVE)
+PREDICATE_KERNEL(int16_t, s16, s16, LOAD_NATIVE)
+PREDICATE_KERNEL(uint16_t, u16, u16, LOAD_NATIVE)
+PREDICATE_KERNEL(int32_t, s32, s32, LOAD_NATIVE)
+PREDICATE_KERNEL(uint32_t, u32, u32, LOAD_NATIVE)
+#ifndef NO_64BIT_VALUES
+PREDICATE_KERNEL(int64_t, s64, s64, LOAD_NATIVE)
+PREDICATE_KERNEL(uint64_t, u64, u64, LOAD_NATIVE)
+#endif
+#ifndef NO_FLOAT_VALUES
+PREDICATE_KERNEL(float, f32, f32, LOAD_NATIVE)
+PREDICATE_KERNEL(double, f64, f64, LOAD_NATIVE)
+#endif
+
+PREDICATE_KERNEL(int16_t, s16, be16, LOAD_BE16)
+PREDICATE_KERNEL(int32_t, s32, be32, LOAD_BE32)
+#ifndef NO_64BIT_VALUES
+PREDICATE_KERNEL(int64_t, s64, be64, LOAD_BE64)
+#endif
+
+/*
+ * Within kernels test the Euclidean distance of `pred->size` values at
+ * addresses a, a+stride, ... from the point `pred->center`. The remaining
+ * values are not loaded once the distance exceeds the radius.
+ */
+#define WITHIN_KERNEL(T, field)                                             \
+static int within_kernel_##field(const struct ast_predicate *pred,          \
+                                 struct hits *hits, enum value_type type,   \
+                                 const char *buf, addr_t base,              \
+                                 addr_t from, addr_t to, addr_t align)      \
+{                                                                           \
+    const double *center = pred->center;                                    \
+    const double radius2 = pred->radius2;                                   \
+    const size_t n = pred->size, stride = pred->stride;                     \
+    addr_t address;                                                         \
+    for (address = from; address < to; address += align) {                  \
+        const char *data = &buf[address - base];                            \
+        double d2 = 0;                                                      \
+        size_t i;                                                           \
+        for (i = 0; i < n && d2 <= radius2; i++) {                          \
+            T x;                                                            \
+            double d;                                                       \
+            memcpy(&x, &data[i*stride], sizeof(T));                         \
+            d = x - center[i];                                              \
+            d2 += d*d;                                                      \
+        }                                                                   \
+        if (d2 <= radius2 && !hits_add(hits, address, type,                 \
+                                       (union value_data *)data)) {         \
+            return 0;                                                       \
+        }                                                                   \
+    }                                                                       \
+    return 1;                                                               \
+}
+
+#ifndef NO_FLOAT_VALUES
+WITHIN_KERNEL(float, f32)
+WITHIN_KERNEL(double, f64)
+#endif
+
+/*
+ * Bytes kernel finds matches of a bytes() pattern. Candidates are located by
+ * memchr() of the anchor byte (which the C library vectorizes) and verified
+ * against the whole pattern. Patterns without an anchor are tested at each
+ * address.
+ */
+static int bytes_match(const struct ast_predicate *pred,
+                       const unsigned char *data)
+{
+    size_t i;
+    for (i = 0; i < pred->size; i++) {
+        if ((data[i] & pred->mask[i]) != pred->pattern[i])
+            return 0;
+    }
+    return 1;
+}
+
+static int bytes_kernel(const struct ast_predicate *pred,
+                        struct hits *hits, enum value_type type,
+                        const char *buf, addr_t base,
+                        addr_t from, addr_t to, addr_t align)
+{
+    const unsigned char *data, *p, *end;
+    size_t k = pred->anchor;
+    addr_t address;
+
+    if (k == pred->size) {
+        for (address = from; address < to; address += align) {
+            data = (const unsigned char *)&buf[address - base];
+            if (bytes_match(pred, data)
+                    && !hits_add(hits, address, type,
+                                 (union value_data *)data)) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    p = (const unsigned char *)&buf[from - base] + k;
+    end = (const unsigned char *)&buf[to - base] + k;
+    for (; p < end && (p = memchr(p, pred->pattern[k], end - p)); p++) {
+        data = p - k;
+        address = base + ((const char *)data - buf);
+        if ((address - from) % align == 0 && bytes_match(pred, data)
+                && !hits_add(hits, address, type, (union value_data *)data)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static const predicate_kernel predicate_kernels[VALUE_TYPES] = {
+    predicate_kernel_s8, predicate_kernel_u8,
+    predicate_kernel_s16, predicate_kernel_u16,
+    predicate_kernel_s32, predicate_kernel_u32,
+    #ifndef NO_64BIT_VALUES
+    predicate_kernel_s64, predicate_kernel_u64,
+    #endif
+    #ifndef NO_FLOAT_VALUES
+    predicate_kernel_f32, predicate_kernel_f64,
+    #endif
+};
+
+/*
+ * Predicate kernel testing values of type `type` against a predicate `pred`
+ * (or NULL if none). Proximity tests within() are accepted only for vectors
+ * at the address symbol `addr_sym` (if nonzero).
+ */
+static predicate_kernel predicate_kernel_of(const struct ast_predicate *pred,
+                                            size_t addr_sym,
+                                            enum value_type type)
+{
+    if (pred->type != value_type_unswapped(type))
+        return NULL;
+    if (pred->op == AST_BYTES)
+        return (addr_sym && pred->addr == addr_sym) ? bytes_kernel : NULL;
+    if (pred->op == AST_WITHIN) {
+    #ifndef NO_FLOAT_VALUES
+        if (addr_sym && pred->addr == addr_sym
+                && pred->stride <= SCAN_CHUNK_SIZE / pred->size) {
+            if (type == F32) return within_kernel_f32;
+            if (type == F64) return within_kernel_f64;
+        }
+    #endif
+        return NULL;
+    }
+    switch (type) {
+    case BE16: return predicate_kernel_be16;
+    case BE32: return predicate_kernel_be32;
+    #ifndef NO_64BIT_VALUES
+    case BE64: return predicate_kernel_be64;
+    #endif
+    default: break;
+    }
+    return predicate_kernels[value_type_index(type)];
+}
+
+/*
+ * Predicate kernel for an expression of the value symbol `sym` of type `type`
+ * (or NULL if the expression is not a simple predicate).
+ */
+static predicate_kernel predicate_kernel_new(struct ast *ast, size_t sym,
+                                             size_t addr_sym,
+                                             enum value_type type,
+                                             struct ast_predicate *pred)
+{
+    if (!ast_predicate(ast, sym, pred))
+        return NULL;
+    return predicate_kernel_of(pred, addr_sym, type);
+}
+
+/*
+ * Maximum number of distinct pages remembered by page deduplication.
+ */
+#define DEDUP_PAGES_MAX (1024*1024)
+
+/*
+ * Hits of distinct pages of a search keyed by 64-bit hashes of the page
+ * contents. Hits are recorded as offsets relative to the start of a page,
+ * so they can be reused for any later page with identical contents. The
+ * earlier page is read again to compare the contents on a hash match.
+ */
+struct dedup {
+    struct dedup_page {
+        uint64_t hash;
+        addr_t page, span; /* page address and length of its scanned part */
+        size_t first, count; /* offsets[first...first+count-1] */
+    } *pages;
+    size_t size, capacity;
+
+    uint32_t *offsets;
+    size_t offsets_size, offsets_capacity;
+
+    char *buf; /* contents of an earlier page */
+};
+#define DEDUP_EMPTY ((size_t)-1)
+
+static uint64_t page_hash(const char *data, size_t len)
+{
+    size_t i;
+    uint64_t w, h = UINT64_C(0x27D4EB2F165667C5) ^ len;
+    for (i = 0; i + sizeof(w) <= len; i += sizeof(w)) {
+        memcpy(&w, &data[i], sizeof(w));
+        w *= UINT64_C(0xC2B2AE3D27D4EB4F);
+        h ^= (w << 31) | (w >> 33);
+        h = ((h << 27) | (h >> 37)) * UINT64_C(0x9E3779B185EBCA87);
+    }
+    h ^= h >> 33;
+    h *= UINT64_C(0x165667B19E3779F9);
+    return h ^ (h >> 29);
+}
+
+static struct dedup *dedup_new()
+{
+    struct dedup *dedup;
+    if ((dedup = calloc(1, sizeof(struct dedup)))) {
+        size_t i;
+        dedup->capacity = 1024;
+        if (!(dedup->pages = malloc(dedup->capacity * sizeof(*dedup->pages)))
+                || !(dedup->buf = malloc(target_page_size()))) {
+            free(dedup->pages);
+            free(dedup);
+            return NULL;
+        }
+        for (i = 0; i < dedup->capacity; i++)
+            dedup->pages[i].first = DEDUP_EMPTY;
+    }
+    return dedup;
+}
+
+static void dedup_delete(struct dedup *dedup)
+{
+    free(dedup->pages);
+    free(dedup->offsets);
+    free(dedup->buf);
+    free(dedup);
+}
+
+/* Find page with a hash, or an empty slot for it */
+static struct dedup_page *dedup_find(struct dedup_page *pages,
+                                     size_t capacity, uint64_t hash)
+{
+    size_t i = (size_t)hash & (capacity - 1);
+    while (pages[i].first != DEDUP_EMPTY && pages[i].hash != hash)
+        i = (i + 1) & (capacity - 1);
+    return &pages[i];
+}
+
+/* Remember hits (addresses in [page, page+span)) of a page with a hash */
+static int dedup_add(struct dedup *dedup, uint64_t hash, addr_t page,
+                     addr_t span, const struct hit *hits, size_t count)
 {
+    size_t i;
+    struct dedup_page *entry;
+
+    if (dedup->size >= DEDUP_PAGES_MAX)
+        return 0;
+
+    if (2*(dedup->size + 1) > dedup->capacity) {
+        struct dedup_page *pages;
+        size_t capacity = 2*dedup->capacity;
+        if (!(pages = malloc(capacity * sizeof(*pages))))
+            return 0;
+        for (i = 0; i < capacity; i++)
+            pages[i].first = DEDUP_EMPTY;
+        for (i = 0; i < dedup->capacity; i++) {
+            if (dedup->pages[i].first != DEDUP_EMPTY)
+                *dedup_find(pages, capacity, dedup->pages[i].hash)
+                    = dedup->pages[i];
+        }
+        free(dedup->pages);
+        dedup->pages = pages;
+        dedup->capacity = capacity;
+    }
+
+    if (dedup->offsets_size + count > dedup->offsets_capacity) {
+        uint32_t *offsets;
+        size_t capacity = dedup->offsets_capacity ? dedup->offsets_capacity
+                                                  : 1024;
+        while (capacity < dedup->offsets_size + count)
+            capacity *= 2;
+        if (!(offsets = realloc(dedup->offsets, capacity * sizeof(uint32_t))))
+            return 0;
+        dedup->offsets = offsets;
+        dedup->offsets_capacity = capacity;
+    }
+
+    entry = dedup_find(dedup->pages, dedup->capacity, hash);
+    if (entry->first == DEDUP_EMPTY)
+        dedup->size++;
+    entry->hash = hash;
+    entry->page = page;
+    entry->span = span;
+    entry->first = dedup->offsets_size;
+    entry->count = count;
+    for (i = 0; i < count; i++)
+        dedup->offsets[dedup->offsets_size++] = (uint32_t)(hits[i].addr - page);
+    return 1;
+}
+
+/*
+ * State of a search scanning memory regions for values of a type. A search
+ * of several types reads each chunk of memory once and scans it for each.
+ */
+struct scan {
     struct target *target;
-    struct region *mr, *regions, *new;
+    struct scan_target *view;
+    struct ast *ast;
+    struct hits *hits;
+    enum value_type type;
+    size_t size;
+    addr_t align, origin;
+    struct value addr;
+    union value_data **ppdata;
+    int swapped;
+
+    /* Symbols referenced by the expression (others are never updated) */
+    int addr_live, value_live;
+
+    /* Expression depends only on the value (not on address or target) */
+    int value_only;
+
+    /* Native copy of a byte-swapped value referred by the value symbol */
+    union value_data native;
+
+    /* Truth table of the expression for 8- and 16-bit values (or NULL) */
+    unsigned char *truth;
+
+    /* Kernel testing the predicate descriptor `pred` (or NULL) */
+    predicate_kernel kernel;
+    struct ast_predicate pred;
+
+    /* Predicate is a conjunct of the expression verifying the kernel hits */
+    int anchored;
+
+    /* Hits of distinct pages (or NULL if deduplication is disabled) */
+    struct dedup *dedup;
+
+    /* Last bytes of the previous run (for values spanning two runs) */
+    addr_t tail_end;
+    size_t tail_size;
+    char tail[sizeof(union value_data)];
+
+    /* Scanned part [start, end) of the current region (see scan_clip()) */
+    int active;
+    addr_t start, end;
+};
+
+/*
+ * Pages of a region are scanned in runs of pages of the same class.
+ */
+enum page_class {
+    PAGE_READ,  /* Read and scan */
+    PAGE_ZERO,  /* Never-touched anonymous memory reading as zeros */
+    PAGE_SKIP   /* Swapped out or unreadable */
+};
+
+static int region_is_anonymous(const struct region *region)
+{
+    return !region->path
+        || !strcmp(region->path, "[heap]")
+        || !strncmp(region->path, "[stack", 6)
+        || !strncmp(region->path, "[anon:", 6);
+}
+
+static enum page_class page_class(const struct scan *scan,
+                                  unsigned char flags, int anonymous)
+{
+    if (flags & MEM_PAGE_PRESENT)
+        return PAGE_READ;
+    if (flags & MEM_PAGE_SWAPPED)
+        return scan->swapped ? PAGE_READ : PAGE_SKIP;
+    return anonymous ? PAGE_ZERO : PAGE_READ;
+}
+
+/* First scanned (aligned) address at or after `from` */
+static addr_t scan_first(const struct scan *scan, addr_t from)
+{
+    addr_t offset;
+    if (from <= scan->origin)
+        return scan->origin;
+    if ((offset = (from - scan->origin) % scan->align))
+        from += scan->align - offset;
+    return from;
+}
+
+/* Point the value symbol to `data` (or to its native copy if byte-swapped) */
+static void scan_value(struct scan *scan, const char *data)
+{
+    if (value_type_is_swapped(scan->type)) {
+        memcpy(&scan->native, data, scan->size);
+        value_data_swap(&scan->native, scan->size);
+        *scan->ppdata = &scan->native;
+    } else {
+        *scan->ppdata = (union value_data *)data;
+    }
+}
+
+/*
+ * Evaluate the expression for hits[first...] of an anchored kernel in a
+ * buffer `buf` (starting from address `base`) and drop the failing ones.
+ */
+static void scan_verify(struct scan *scan, const char *buf, addr_t base,
+                        umax_t first)
+{
+    struct hits *hits = scan->hits;
+    umax_t i, k;
+
+    for (i = k = first; i < hits->size; i++) {
+        struct value value;
+        addr_t address = hits->items[i].addr;
+        if (scan->addr_live)
+            addr_store(&scan->addr, address);
+        if (scan->value_live)
+            scan_value(scan, &buf[address - base]);
+        if (ast_evaluate(scan->ast, &value) && value_is_nonzero(&value))
+            hits->items[k++] = hits->items[i];
+    }
+    hits->size = k;
+}
+
+/*
+ * Evaluate the expression for values at aligned addresses in [from, to) of a
+ * buffer `buf` containing memory starting from address `base`. The loop is
+ * specialized for the symbols referenced by the expression, i.e., `update`
+ * stores only the live symbols of each address.
+ */
+#define SCAN_BUFFER_LOOP(update)                                            \
+    for (address = from; address < to; address += scan->align) {           \
+        const char *data = &buf[address - base];                            \
+        update;                                                             \
+        if (ast_evaluate(scan->ast, &value) && value_is_nonzero(&value)) {  \
+            if (!hits_add(scan->hits, address, scan->type,                  \
+                          (union value_data *)data)) {                      \
+                return 0;                                                   \
+            }                                                               \
+        }                                                                   \
+    }
+
+static int scan_buffer(struct scan *scan, const struct region *region,
+                       const char *buf, addr_t base, addr_t from, addr_t to)
+{
+    struct value value;
+    addr_t address;
+
+    if ((from = scan_first(scan, from)) >= to)
+        return 1;
+
+    if (scan->truth) {
+        for (address = from; address < to; address += scan->align) {
+            const char *data = &buf[address - base];
+            uint16_t x;
+            if (scan->size == 1) {
+                x = *(const unsigned char *)data;
+            } else {
+                memcpy(&x, data, sizeof(uint16_t));
+            }
+            if (truth_table_test(scan->truth, x)) {
+                if (!hits_add(scan->hits, address, scan->type,
+                              (union value_data *)data)) {
+                    return 0;
+                }
+            }
+        }
+        return 1;
+    }
+
+    if (scan->kernel) {
+        umax_t first = scan->hits->size;
+        addr_t end = to, span = 0;
+        if (scan->pred.op == AST_WITHIN) {
+            span = (scan->pred.size - 1) * scan->pred.stride;
+        } else if (scan->pred.op == AST_BYTES) {
+            span = scan->pred.size - 1;
+        }
+        if (span) {
+            /* Values reaching past the buffer are evaluated below */
+            end = (to - from > span) ? to - span : from;
+        }
+        if (!scan->kernel(&scan->pred, scan->hits, scan->type, buf, base,
+                          from, end, scan->align)) {
+            return 0;
+        }
+        if (scan->anchored)
+            scan_verify(scan, buf, base, first);
+        if ((from = scan_first(scan, end)) >= to)
+            return 1;
+    }
+
+    if (scan->value_live && value_type_is_swapped(scan->type)) {
+        if (scan->addr_live) {
+            SCAN_BUFFER_LOOP(addr_store(&scan->addr, address);
+                             scan_value(scan, data))
+        } else {
+            SCAN_BUFFER_LOOP(scan_value(scan, data))
+        }
+    } else if (scan->addr_live && scan->value_live) {
+        SCAN_BUFFER_LOOP(addr_store(&scan->addr, address);
+                         *scan->ppdata = (union value_data *)data)
+    } else if (scan->addr_live) {
+        SCAN_BUFFER_LOOP(addr_store(&scan->addr, address))
+    } else if (scan->value_live) {
+        SCAN_BUFFER_LOOP(*scan->ppdata = (union value_data *)data)
+    } else {
+        SCAN_BUFFER_LOOP((void)0)
+    }
+    return 1;
+}
+
+/*
+ * Scan aligned addresses in [from, to) all holding the same value `data`.
+ * Unless the expression depends on the address, it is evaluated only once
+ * and all the addresses are either skipped or added as hits in bulk.
+ */
+static int scan_repeat(struct scan *scan, const struct region *region,
+                       union value_data *data, addr_t from, addr_t to)
+{
+    struct value value;
+    addr_t address;
+
+    if ((from = scan_first(scan, from)) >= to)
+        return 1;
+
+    scan_value(scan, (const char *)data);
+    if (!scan->value_only) {
+        for (address = from; address < to; address += scan->align) {
+            if (scan->addr_live)
+                addr_store(&scan->addr, address);
+            if (ast_evaluate(scan->ast, &value) && value_is_nonzero(&value)) {
+                if (!hits_add(scan->hits, address, scan->type, data))
+                    return 0;
+            }
+        }
+    } else if (ast_evaluate(scan->ast, &value) && value_is_nonzero(&value)) {
+        for (address = from; address < to; address += scan->align) {
+            if (!hits_add(scan->hits, address, scan->type, data))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Scan values at aligned addresses [page, last) of a whole page, reusing
+ * hits of a previously scanned page with identical contents if possible.
+ */
+static int scan_dedup(struct scan *scan, const struct region *region,
+                      const char *buf, addr_t base, addr_t page, addr_t last)
+{
+    struct dedup_page *entry;
+    umax_t size = scan->hits->size;
+    size_t page_size = target_page_size();
+    uint64_t hash = page_hash(&buf[page - base], page_size);
+
+    entry = dedup_find(scan->dedup->pages, scan->dedup->capacity, hash);
+    if (entry->first != DEDUP_EMPTY && entry->span == last - page
+            && scan->target->read(scan->target, entry->page,
+                                  scan->dedup->buf, page_size)
+            && !memcmp(scan->dedup->buf, &buf[page - base], page_size)) {
+        size_t i;
+        for (i = entry->first; i < entry->first + entry->count; i++) {
+            addr_t address = page + scan->dedup->offsets[i];
+            if (!hits_add(scan->hits, address, scan->type,
+                          (union value_data *)&buf[address - base])) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    if (!scan_buffer(scan, region, buf, base, page, last))
+        return 0;
+    dedup_add(scan->dedup, hash, page, last - page, &scan->hits->items[size],
+              scan->hits->size - size);
+    return 1;
+}
+
+/*
+ * Scan a buffer of memory starting from `base` page by page. The values at
+ * aligned addresses of a page repeating a pattern of `align` bytes (such as
+ * zero-filled and memset pages) are all equal, so those are scanned by
+ * scan_repeat(). Here memcmp(3) of the page against itself does the
+ * vectorized heavy lifting, and bails out early for pages of varying data.
+ */
+static int scan_pages(struct scan *scan, const struct region *region,
+                      const char *buf, addr_t base, addr_t from, addr_t to)
+{
+    size_t page_size = target_page_size();
+    addr_t end = to + scan->size - 1;
+
+    if (!scan->value_only || page_size < 2*scan->align)
+        return scan_buffer(scan, region, buf, base, from, to);
+
+    while (from < to) {
+        addr_t page = from - (from - base) % page_size;
+        addr_t next = (end - page > page_size) ? page + page_size : end;
+        addr_t last = next - scan->size + 1;
+        const char *data = &buf[page - base];
+        size_t len = next - page;
+
+        if (last > to)
+            last = to;
+        if (len >= 2*scan->align
+                && !memcmp(data, data + scan->align, len - scan->align)) {
+            addr_t first = scan_first(scan, from);
+            if (first < last && !scan_repeat(scan, region,
+                    (union value_data *)&buf[first - base], first, last)) {
+                return 0;
+            }
+            if (!scan_buffer(scan, region, buf, base, last,
+                             (next < to) ? next : to)) {
+                return 0;
+            }
+        } else if (scan->dedup && from == page && len == page_size) {
+            if (!scan_dedup(scan, region, buf, base, page, last)
+                    || !scan_buffer(scan, region, buf, base, last,
+                                    (next < to) ? next : to)) {
+                return 0;
+            }
+        } else if (!scan_buffer(scan, region, buf, base, from,
+                                (next < to) ? next : to)) {
+            return 0;
+        }
+        from = next;
+    }
+    return 1;
+}
+
+/*
+ * Scan a run [from, to) of pages of the same class from `buf` (which is NULL
+ * for zero pages and skipped pages).
+ */
+static int scan_run_type(struct scan *scan, const struct region *region,
+                         enum page_class class, const char *buf,
+                         addr_t from, addr_t to)
+{
+    size_t head;
+
+    if (class == PAGE_SKIP) {
+        scan_target_view(scan->view, 0, NULL, 0);
+        scan->tail_size = 0;
+        return 1;
+    }
+    if (class == PAGE_READ) {
+        scan_target_view(scan->view, from, buf, to - from);
+    } else {
+        scan_target_view(scan->view, 0, NULL, 0);
+    }
+
+    head = (to - from < scan->size) ? to - from : scan->size - 1;
+    if (scan->tail_size && scan->tail_end == from
+            && scan->tail_size + head >= scan->size) {
+        char stitch[2*sizeof(union value_data)];
+        addr_t base = from - scan->tail_size;
+        memcpy(stitch, scan->tail, scan->tail_size);
+        if (buf) {
+            memcpy(&stitch[scan->tail_size], buf, head);
+        } else {
+            memset(&stitch[scan->tail_size], 0, head);
+        }
+        if (!scan_buffer(scan, region, stitch, base, base,
+                         from + head - scan->size + 1)) {
+            return 0;
+        }
+    }
+
+    if (to - from >= scan->size) {
+        addr_t last = to - scan->size + 1;
+        union value_data zero;
+        memset(&zero, 0, sizeof(zero));
+        if (buf ? !scan_pages(scan, region, buf, from, from, last)
+                : !scan_repeat(scan, region, &zero, from, last)) {
+            return 0;
+        }
+    }
+
+    if (buf) {
+        memcpy(scan->tail, &buf[to - from - head], head);
+    } else {
+        memset(scan->tail, 0, head);
+    }
+    scan->tail_size = head;
+    scan->tail_end = to;
+    return 1;
+}
+
+/*
+ * Scan a run [from, to) of pages of the same class using `buf` for reading.
+ * The run is read once and scanned for each of the `n` active types.
+ */
+static int scan_run(struct scan *scans, size_t n, const struct region *region,
+                    enum page_class class, char *buf, addr_t from, addr_t to)
+{
+    struct target *target = scans[0].target;
+    size_t i;
+
+    if (class == PAGE_READ && !target->read(target, from, buf, to - from))
+        class = PAGE_SKIP;
+    for (i = 0; i < n; i++) {
+        struct scan *scan = &scans[i];
+        addr_t start = (from < scan->start) ? scan->start : from;
+        addr_t end = (to > scan->end) ? scan->end : to;
+        if (!scan->active || start >= end)
+            continue;
+        if (!scan_run_type(scan, region, class,
+                           (class == PAGE_READ) ? &buf[start - from] : NULL,
+                           start, end)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Scan a region with a stride of at least a page by reading only the values
+ * at the scanned addresses.
+ */
+static int scan_sparse(struct scan *scan, const struct region *region,
+                       char *buf, int anonymous)
+{
+    addr_t address = scan->origin;
+    addr_t end = region->start + region->size;
+
+    while (end - address >= scan->size) {
+        unsigned char flags;
+        enum page_class class = PAGE_READ;
+        if (scan->target->pages(scan->target, address, scan->size, &flags))
+            class = page_class(scan, flags, anonymous);
+
+        if (class == PAGE_ZERO) {
+            memset(buf, 0, scan->size);
+        } else if (class == PAGE_SKIP || !scan->target->read(scan->target,
+                                                  address, buf, scan->size)) {
+            class = PAGE_SKIP;
+        }
+        if (class != PAGE_SKIP) {
+            scan_target_view(scan->view, address, buf, scan->size);
+            if (!scan_buffer(scan, region, buf, address, address, address+1))
+                return 0;
+        }
+        if (end - address < scan->align)
+            break;
+        address += scan->align;
+    }
+    scan_target_view(scan->view, 0, NULL, 0);
+    return 1;
+}
+
+/*
+ * Clip a region to the pages that can hold hits satisfying address bounds
+ * and set the origin of the scanned addresses (aligned to `align` from the
+ * region start, and congruent to bounds->rem if scanning with a stride of
+ * bounds->mod). Returns 0 if no address of the region can be a hit.
+ */
+static int scan_clip(struct scan *scan, const struct ast_bounds *bounds,
+                     addr_t align, const struct region *region,
+                     struct region *out)
+{
+    size_t page_size = target_page_size();
+    addr_t first, last, offset, end = region->start + region->size;
+    addr_t region_end = end;
+
+    if (region->size < scan->size)
+        return 0;
+    if (bounds->region && !(region->path
+                            && strstr(region->path, bounds->region))) {
+        return 0;
+    }
+
+    first = region->start;
+    last = end - scan->size;
+    if (bounds->lo > last || bounds->hi < first || bounds->lo > bounds->hi)
+        return 0;
+    if (bounds->lo > first)
+        first = (addr_t)bounds->lo;
+    if (bounds->hi < last)
+        last = (addr_t)bounds->hi;
+
+    if ((offset = (first - region->start) % align)) {
+        if (align - offset > last - first)
+            return 0;
+        first += align - offset;
+    }
+    if (bounds->mod && scan->align == bounds->mod) {
+        /* Stride is a multiple of align, so the residues must agree */
+        addr_t delta;
+        if (region->start % align != bounds->rem % align)
+            return 0;
+        delta = (bounds->rem + bounds->mod - first % bounds->mod)
+              % bounds->mod;
+        if (delta > last - first)
+            return 0;
+        first += delta;
+    } else if (bounds->mod && align % bounds->mod == 0) {
+        /* All aligned addresses are congruent modulo bounds->mod */
+        if (first % bounds->mod != bounds->rem)
+            return 0;
+    }
+    scan->origin = first;
+
+    /* Pages of the region around the possible hits */
+    *out = *region;
+    out->start = first - first % page_size;
+    if (out->start < region->start)
+        out->start = region->start;
+    end = last + scan->size;
+    if ((offset = end % page_size)) {
+        addr_t page_end = end + (page_size - offset);
+        end = (page_end > end && page_end < region_end) ? page_end
+                                                        : region_end;
+    }
+    out->size = end - out->start;
+    return 1;
+}
+
+/*
+ * Scan a memory region in chunks of `size` bytes. Residency of the pages of
+ * each chunk is queried first, so that swapped out pages are not read (and
+ * swapped in) and never-touched anonymous pages are not read at all. Each
+ * chunk is scanned for the `n` types active in the region; types scanned
+ * with a stride of at least a page read only their own values instead.
+ */
+static int scan_region(struct scan *scans, size_t n,
+                       const struct region *region,
+                       char *buf, size_t size, unsigned char *pages)
+{
+    addr_t chunk;
+    size_t i, page_size = target_page_size();
+    addr_t end = region->start + region->size;
+    int dense, anonymous = region_is_anonymous(region);
+
+    for (i = dense = 0; i < n; i++) {
+        struct scan *scan = &scans[i];
+        scan->tail_size = 0;
+        if (scan->active && scan->align >= page_size) {
+            struct region sparse = *region;
+            sparse.start = scan->start;
+            sparse.size = scan->end - scan->start;
+            scan->active = 0;
+            if (!scan_sparse(scan, &sparse, buf, anonymous))
+                return 0;
+        }
+        dense += scan->active;
+    }
+    if (!dense)
+        return 1;
+
+    for (chunk = region->start; chunk < end; chunk += size) {
+        size_t j, count, len;
+        struct target *target = scans[0].target;
+        len = (end - chunk < size) ? end - chunk : size;
+        count = (len + page_size-1) / page_size;
+        if (!target->pages(target, chunk, len, pages))
+            memset(pages, MEM_PAGE_PRESENT, count);
+
+        for (i = 0; i < count; i = j) {
+            addr_t from, to;
+            enum page_class class = page_class(scans, pages[i], anonymous);
+            for (j = i + 1; j < count; j++) {
+                if (page_class(scans, pages[j], anonymous) != class)
+                    break;
+            }
+            from = chunk + i*page_size;
+            to = (j < count) ? chunk + j*page_size : chunk + len;
+            if (!scan_run(scans, n, region, class, buf, from, to))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* Scan of the type of a hit */
+static struct scan *scan_of(struct scan *scans, size_t n, enum value_type type)
+{
+    size_t i;
+    for (i = 0; i < n - 1 && scans[i].type != type; i++);
+    return &scans[i];
+}
+
+/*
+ * Re-verify hits of a non-stop search against the (stopped) target.
+ *
+ * Hits are sorted by address, so nearby hits are coalesced into spans of at
+ * most `size` bytes and each span is read with a single target->read() call.
+ * Each hit is verified by the expression of its type (one of the `n` scans).
+ * Hits whose values no longer satisfy the expression are dropped in-place.
+ */
+static void verify_hits(struct scan *scans, size_t n, struct hits *hits,
+                        char *buf, size_t size)
+{
+    struct target *target = scans[0].view->target;
+    umax_t i, j, k;
+    size_t l;
+
+    for (i = k = 0; i < hits->size; i = j) {
+        size_t len;
+        addr_t start = hits->items[i].addr;
+        addr_t end = start + scan_of(scans, n, hits->items[i].type)->size;
+        for (j = i + 1; j < hits->size; j++) {
+            struct hit *hit = &hits->items[j];
+            addr_t last = hit->addr + scan_of(scans, n, hit->type)->size;
+            if (last - start > size
+                    || hit->addr - hits->items[j-1].addr > VERIFY_GAP_MAX)
+                break;
+            if (end < last)
+                end = last;
+        }
+
+        len = end - start;
+        if (!target->read(target, start, buf, len)) {
+            len = scan_of(scans, n, hits->items[i].type)->size;
+            if (j - i == 1 || !target->read(target, start, buf, len)) {
+                j = i + 1;
+                continue;
+            }
+            j = i + 1;
+        }
+
+        for (l = 0; l < n; l++)
+            scan_target_view(scans[l].view, start, buf, len);
+        for (; i < j; i++) {
+            struct value value;
+            struct hit *hit = &hits->items[i];
+            struct scan *scan = scan_of(scans, n, hit->type);
+            const char *data = &buf[hit->addr - start];
+            scan_value(scan, data);
+            addr_store(&scan->addr, hit->addr);
+            if (ast_evaluate(scan->ast, &value) && value_is_nonzero(&value)) {
+                hits->items[k] = *hit;
+                memcpy(&hits->items[k].prev, data, scan->size);
+                k++;
+            }
+        }
+    }
+    for (l = 0; l < n; l++)
+        scan_target_view(scans[l].view, 0, NULL, 0);
+    hits->size = k;
+}
+
+/*
+ * Expression compiled for a search or filter.
+ *
+ * Compiled expressions are cached by their normalized text, in which numeric
+ * literals are parameters (see parse_normalize()). The cached AST is parsed
+ * but not optimized, so running an expression again with other constants
+ * skips lexing, parsing and building the symbol table. The constants are
+ * bound to the parameters by copying the AST (see ast_copy()).
+ */
+struct compiled {
+    struct compiled *next; /* less recently used */
+    char *text;
+    int cached;
+
+    /* Symbols preceding the parameters $1, $2, ... in the symbol table */
+    const char *const *names;
+    enum value_type *types; /* including the BE flag */
+    size_t symbols;
+    enum value_type addr_type;
+
+    struct symbol_table *symtab;
+    struct value *params;
+    size_t params_size;
+
+    struct scan_target st;
+    struct ast_arena arena;
+    struct ast *ast;
+};
+
+static void compiled_delete(struct compiled *c)
+{
+    if (c->symtab) symbol_table_delete(c->symtab);
+    ast_arena_reset(&c->arena);
+    free(c->text);
+    free(c);
+}
+
+void compiled_flush(struct ramfuck *ctx)
+{
+    while (ctx->compiled) {
+        struct compiled *next = ctx->compiled->next;
+        compiled_delete(ctx->compiled);
+        ctx->compiled = next;
+    }
+}
+
+static int compiled_match(struct compiled *c, const char *const *names,
+                          const enum value_type *types, size_t symbols,
+                          enum value_type addr_type, const char *text,
+                          const struct value *params, size_t params_size)
+{
+    size_t i;
+    if (c->names != names || c->symbols != symbols
+            || c->addr_type != addr_type || c->params_size != params_size
+            || strcmp(c->text, text)) {
+        return 0;
+    }
+    for (i = 0; i < symbols; i++) {
+        if (c->types[i] != types[i])
+            return 0;
+    }
+    for (i = 0; i < params_size; i++) {
+        if (c->params[i].type != params[i].type)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Compile an expression with symbols `names` of `types` followed by the
+ * parameters bound to `args` and numeric literals of the expression. The
+ * symbols of byte-swapped types hold unswapped values.
+ *
+ * The returned expression, whose scan target wraps `target`, must be
+ * released by compiled_release(). The AST is bound to the parameters by
+ * ast_copy(c->ast, c->symbols + 1).
+ */
+static struct compiled *compile(struct ramfuck *ctx, const char *who,
+                                const char *const *names,
+                                const enum value_type *types, size_t symbols,
+                                enum value_type addr_type,
+                                struct target *target, const char *expression,
+                                const struct value *args, size_t args_size)
+{
+    char text[COMPILED_TEXT_MAX];
+    struct value params[COMPILED_PARAMS_MAX];
+    const struct value *values;
+    struct compiled *c, **pc;
+    struct parser parser;
+    size_t i, n;
+    int rc;
+
+    /* Literals become parameters after the arguments */
+    rc = 0;
+    n = args_size;
+    if (n <= COMPILED_PARAMS_MAX) {
+        for (i = 0; i < n; i++)
+            params[i] = args[i];
+        rc = parse_normalize(expression, text, sizeof(text),
+                             params, &n, COMPILED_PARAMS_MAX);
+        if (rc < 0) {
+            errf("%s: invalid tokens in expression", who);
+            return NULL;
+        }
+    }
+    if (rc) {
+        values = params;
+        for (pc = &ctx->compiled; (c = *pc); pc = &c->next) {
+            if (compiled_match(c, names, types, symbols, addr_type,
+                               text, params, n)) {
+                *pc = c->next;
+                c->next = ctx->compiled;
+                ctx->compiled = c;
+                for (i = 0; i < n; i++)
+                    c->params[i] = params[i];
+                scan_target_init(&c->st, target);
+                return c;
+            }
+        }
+    } else {
+        values = args;
+        n = args_size;
+    }
+
+    if (!(c = malloc(sizeof(struct compiled)))) {
+        errf("%s: out-of-memory for compiled expression", who);
+        return NULL;
+    }
+    c->next = NULL;
+    c->text = NULL;
+    c->cached = 0;
+    c->names = names;
+    c->symbols = symbols;
+    c->addr_type = addr_type;
+    c->params_size = n;
+    c->ast = NULL;
+    ast_arena_init(&c->arena);
+    scan_target_init(&c->st, target);
+    if (!(c->symtab = symbol_table_new(ctx))
+            || !(c->params = ast_arena_alloc(&c->arena,
+                                             n * sizeof(struct value)))
+            || !(c->types = ast_arena_alloc(&c->arena, symbols
+                                            * sizeof(enum value_type)))) {
+        errf("%s: out-of-memory for symbol table", who);
+        goto fail;
+    }
+    for (i = 0; i < symbols; i++) {
+        c->types[i] = types[i];
+        if (!symbol_table_add(c->symtab, names[i],
+                              value_type_unswapped(types[i]), NULL)) {
+            goto fail;
+        }
+    }
+    for (i = 0; i < n; i++) {
+        char name[32];
+        c->params[i] = values[i];
+        if (!values[i].type)
+            continue;
+        sprintf(name, "$%lu", (unsigned long)i + 1);
+        if (!symbol_table_add(c->symtab, name, values[i].type,
+                              &c->params[i].data)) {
+            goto fail;
+        }
+    }
+
+    parser_init(&parser);
+    parser.symtab = c->symtab;
+    parser.addr_type = addr_type;
+    parser.target = &c->st.base;
+    parser.arena = &c->arena;
+    if (rc) {
+        /* Parse errors are reported for the original expression */
+        parser.quiet = 1;
+        if ((c->ast = parse_expression(&parser, text))
+                && target == ctx->target
+                && (c->text = malloc(strlen(text) + 1))) {
+            strcpy(c->text, text);
+            c->cached = 1;
+        }
+        parser.quiet = 0;
+        parser.errors = 0;
+    }
+    if (!c->ast && !(c->ast = parse_expression(&parser, expression))) {
+        errf("%s: %d parse errors", who, parser.errors);
+        goto fail;
+    }
+
+    if (c->cached) {
+        c->next = ctx->compiled;
+        ctx->compiled = c;
+        for (i = 1, pc = &c->next; *pc; pc = &(*pc)->next) {
+            if (++i > COMPILED_CACHE_SIZE) {
+                compiled_delete(*pc);
+                *pc = NULL;
+                break;
+            }
+        }
+    }
+    return c;
+
+fail:
+    compiled_delete(c);
+    return NULL;
+}
+
+/* Release a compiled expression after a search or filter */
+static void compiled_release(struct compiled *c)
+{
+    scan_target_detach(&c->st.base);
+    if (!c->cached)
+        compiled_delete(c);
+}
+
+/*
+ * Prepared expression.
+ */
+struct prepared {
+    struct prepared *next;
+    char *expression;
+    char name[1];
+};
+
+int prepare(struct ramfuck *ctx, const char *name, size_t len,
+            const char *expression)
+{
+    struct prepared *p, **pp;
+    for (pp = &ctx->prepared; (p = *pp); pp = &p->next) {
+        if (!strncmp(p->name, name, len) && !p->name[len]) {
+            *pp = p->next;
+            free(p->expression);
+            free(p);
+            break;
+        }
+    }
+    if (!(p = malloc(sizeof(struct prepared) + len))) {
+        errf("prepare: out-of-memory for prepared expression");
+        return 0;
+    }
+    if (!(p->expression = malloc(strlen(expression) + 1))) {
+        errf("prepare: out-of-memory for prepared expression");
+        free(p);
+        return 0;
+    }
+    strcpy(p->expression, expression);
+    memcpy(p->name, name, len);
+    p->name[len] = '\0';
+    p->next = ctx->prepared;
+    ctx->prepared = p;
+    return 1;
+}
+
+const char *prepared(struct ramfuck *ctx, const char *name, size_t len)
+{
+    struct prepared *p;
+    for (p = ctx->prepared; p; p = p->next) {
+        if (!strncmp(p->name, name, len) && !p->name[len])
+            return p->expression;
+    }
+    return NULL;
+}
+
+void prepared_clear(struct ramfuck *ctx)
+{
+    while (ctx->prepared) {
+        struct prepared *next = ctx->prepared->next;
+        free(ctx->prepared->expression);
+        free(ctx->prepared);
+        ctx->prepared = next;
+    }
+    compiled_flush(ctx);
+}
+
+struct hits *search(struct ramfuck *ctx,
+                    const enum value_type *types, size_t types_size,
+                    const char *expression,
+                    const struct value *params, size_t params_size)
+{
+    static const char *const names[] = {"addr", "value"};
+    struct compiled *c[SCAN_TYPES_MAX];
+    struct scan scans[SCAN_TYPES_MAX];
+    struct ast_bounds bounds[SCAN_TYPES_MAX];
+    addr_t aligns[SCAN_TYPES_MAX];
+    struct target *target, *snapshot;
+    struct region_table *table;
+    struct region *regions, *new;
     size_t regions_size, regions_capacity;
-    size_t region_size_max, region_idx, snprint_len_max;
+    size_t region_size_max, region_idx, snprint_len_max, buf_size, i;
     char *region_buf, *snprint_buf;
-    struct parser parser;
-    struct symbol_table *symtab;
+    unsigned char *pages;
+    struct ast_arena arena;
     enum value_type addr_type;
-    struct value value, addr, align_value;
-    const struct value_operations *ops;
-    union value_data **ppdata;
-    struct ast *ast, *opt;
     struct hits *hits, *ret;
-    addr_t align;
-    int quiet;
+    size_t addr_sym, value_sym, t;
+    int quiet, nonstop, stopped;
+
+    if (!types_size || types_size > SCAN_TYPES_MAX) {
+        errf("search: %lu value types given (1 to %d supported)",
+             (unsigned long)types_size, SCAN_TYPES_MAX);
+        return NULL;
+    }
 
-    ast = NULL;
-    symtab = NULL;
+    ast_arena_init(&arena);
+    for (t = 0; t < types_size; t++) {
+        c[t] = NULL;
+        scans[t].truth = NULL;
+        scans[t].kernel = NULL;
+        scans[t].anchored = 0;
+        scans[t].dedup = NULL;
+    }
+    snapshot = NULL;
+    stopped = 0;
     hits = ret = NULL;
+    pages = NULL;
     region_buf = snprint_buf = NULL;
     region_size_max = snprint_len_max = 0;
 
@@ -55,9 +1611,27 @@ struct hits *search(struct ramfuck *ctx, enum value_type type,
     default:  quiet = 0; break;
     }
 
-    addr_type = U32;
     target = ctx->target;
-    for (mr = target->region_first(target); mr; mr = target->region_next(mr)) {
+    if (ctx->config->search.snapshot) {
+        if (ramfuck_break(ctx)) {
+            snapshot = target->snapshot(target);
+            ramfuck_continue(ctx);
+        }
+        if (snapshot) {
+            target = snapshot;
+        } else {
+            warnf("search: snapshot unavailable, scanning the target itself");
+        }
+    }
+
+    if (!(table = target->regions(target))) {
+        errf("search: error reading memory regions of target");
+        goto fail;
+    }
+
+    addr_type = U32;
+    for (i = 0; i < table->size; i++) {
+        const struct region *mr = &table->regions[i];
         if ((mr->prot & ctx->config->search.prot) == ctx->config->search.prot) {
 #if ADDR_BITS == 64
             if (addr_type == U32 && (mr->start + mr->size-1) > UINT32_MAX)
@@ -74,7 +1648,7 @@ struct hits *search(struct ramfuck *ctx, enum value_type type,
                 regions = new;
             }
 
-            region_copy(&regions[regions_size++], mr);
+            regions[regions_size++] = *mr;
 
             if (region_size_max < mr->size)
                 region_size_max = mr->size;
@@ -96,171 +1670,515 @@ struct hits *search(struct ramfuck *ctx, enum value_type type,
     }
     regions = new;
 
-    if (!(region_buf = malloc(region_size_max))) {
+    buf_size = (region_size_max < SCAN_CHUNK_SIZE) ? region_size_max
+                                                    : SCAN_CHUNK_SIZE;
+    if (!(region_buf = malloc(buf_size))) {
         errf("search: out-of-memory for memory region buffer");
         goto fail;
     }
+    if (!(pages = malloc(buf_size / target_page_size() + 1))) {
+        errf("search: out-of-memory for page residency buffer");
+        goto fail;
+    }
 
     if (!quiet && !(snprint_buf = malloc(snprint_len_max + 1))) {
         errf("search: out-of-memory for memory region text representation");
         goto fail;
     }
 
-    if ((symtab = symbol_table_new(ctx))) {
-        size_t value_sym;
-        value_init_zero(&addr, addr_type);
-        if (!(align = ctx->config->search.align))
-            align = value_type_sizeof((type & PTR) ? addr_type : type);
-#if ADDR_BITS == 64
-        if (addr_type == U32) {
-            value_init_u32(&align_value, (uint32_t)align);
-            ops = value_type_ops(U32);
-        } else {
-            value_init_u64(&align_value, (uint64_t)align);
-            ops = value_type_ops(U64);
+    /* Expression of each type is compiled and optimized up front */
+    addr_sym = 1;
+    value_sym = 2;
+    for (t = 0; t < types_size; t++) {
+        struct scan *scan = &scans[t];
+        enum value_type symbol_types[2];
+        struct ast *ast;
+
+        symbol_types[0] = addr_type;
+        symbol_types[1] = types[t];
+        if (!(c[t] = compile(ctx, "search", names, symbol_types, 2, addr_type,
+                             target, expression, params, params_size))) {
+            goto fail;
         }
-#else
-        value_init_addr(&align_value, align);
-        ops = value_type_ops(ADDR);
-#endif
-        symbol_table_add(symtab, "addr", addr.type, &addr.data);
-        value_sym = symbol_table_add(symtab, "value", type, NULL);
-        ppdata = &symtab->symbols[value_sym]->pdata;
-    } else {
-        errf("search: error creating new symbol table");
-        goto fail;
-    }
 
-    parser_init(&parser);
-    parser.symtab = symtab;
-    parser.addr_type = addr_type;
-    parser.target = ctx->target;
-    if (!(ast = parse_expression(&parser, expression))) {
-        errf("search: %d parse errors", parser.errors);
-        goto fail;
+        scan->target = target;
+        scan->view = &c[t]->st;
+        scan->type = types[t];
+        scan->size = value_type_sizeof((types[t] & PTR) ? addr_type
+                                                         : types[t]);
+        scan->swapped = ctx->config->search.swapped;
+        if (!(scan->align = ctx->config->search.align))
+            scan->align = scan->size;
+        aligns[t] = scan->align;
+        value_init_zero(&scan->addr, addr_type);
+        c[t]->symtab->symbols[addr_sym]->pdata = &scan->addr.data;
+        scan->ppdata = &c[t]->symtab->symbols[value_sym]->pdata;
+
+        if (!(ast = ast_copy(&arena, c[t]->ast, c[t]->symbols + 1))) {
+            errf("search: out-of-memory for AST");
+            goto fail;
+        }
+        scan->ast = ast_optimize(&arena, ast);
     }
-    if ((opt = ast_optimize(ast))) {
-        ast_delete(ast);
-        ast = opt;
+
+    nonstop = ctx->config->search.nonstop;
+    if (!snapshot && !nonstop)
+        stopped = ramfuck_break(ctx);
+    for (t = 0; t < types_size; t++) {
+        struct scan *scan = &scans[t];
+        struct ast *ast;
+        unsigned long live;
+
+        scan->ast = ast = ast_cse(&arena, ast_hoist(&arena, scan->ast));
+        live = ast_depends(ast);
+        scan->addr_live = !!(live & AST_DEPENDS_SYMBOL(addr_sym));
+        scan->value_live = !!(live & AST_DEPENDS_SYMBOL(value_sym));
+        scan->value_only = !(live & ~AST_DEPENDS_SYMBOL(value_sym));
+
+        /* Prune regions and addresses by constraints of the address */
+        if (!scan->addr_live || !ast_bounds(ast, addr_sym, &bounds[t])) {
+            bounds[t].lo = 0;
+            bounds[t].hi = (umax_t)-1;
+            bounds[t].mod = bounds[t].rem = 0;
+            bounds[t].region = NULL;
+        }
+        if (bounds[t].mod > aligns[t] && bounds[t].mod % aligns[t] == 0
+                && bounds[t].mod <= (addr_t)-1) {
+            scan->align = (addr_t)bounds[t].mod;
+        }
+        if (scan->value_only) {
+            union value_data data;
+            *scan->ppdata = &data;
+            scan->truth = truth_table_new(ast, scan->type, &data);
+        }
+        if (!scan->truth) {
+            scan->kernel = predicate_kernel_new(ast, value_sym, addr_sym,
+                                                scan->type, &scan->pred);
+        }
+        if (!scan->truth && !scan->kernel
+                && ast_anchor(ast, value_sym, &scan->pred)) {
+            scan->kernel = predicate_kernel_of(&scan->pred, addr_sym,
+                                               scan->type);
+            scan->anchored = !!scan->kernel;
+        }
+        if (scan->value_only && ctx->config->search.dedup
+                && target_page_size() % scan->align == 0
+                && !(scan->dedup = dedup_new())) {
+            errf("search: out-of-memory for page deduplication");
+            goto fail;
+        }
     }
 
     if ((hits = hits_new())) {
         hits->addr_type = addr_type;
-        hits->value_type = type;
+        hits->value_type = (types_size == 1) ? types[0] : 0;
+        for (t = 0; t < types_size; t++)
+            scans[t].hits = hits;
     } else {
         errf("search: error allocating hits container");
         goto fail;
     }
 
-    ramfuck_break(ctx);
     for (region_idx = 0; region_idx < regions_size; region_idx++) {
-        addr_t address;
         const struct region *region = &regions[region_idx];
-        if (!target->read(target, region->start, region_buf, region->size))
+        struct region hull = *region;
+        addr_t end = 0;
+        int active = 0;
+
+        /* Pages around the scanned addresses of all types are read */
+        for (t = 0; t < types_size; t++) {
+            struct region clipped;
+            struct scan *scan = &scans[t];
+            scan->active = scan_clip(scan, &bounds[t], aligns[t], region,
+                                     &clipped);
+            if (!scan->active)
+                continue;
+            scan->start = clipped.start;
+            scan->end = clipped.start + clipped.size;
+            if (!active++) {
+                hull = clipped;
+                end = scan->end;
+            } else {
+                if (hull.start > scan->start)
+                    hull.start = scan->start;
+                if (end < scan->end)
+                    end = scan->end;
+            }
+        }
+        if (!active)
             continue;
+        hull.size = end - hull.start;
+
         if (!quiet) {
             region_snprint(region, snprint_buf, snprint_len_max + 1);
             fprintf(stderr, "%s\n", snprint_buf);
         }
-
-        address = region->start;
-        value_init_addr(&addr, address);
-        ops->assign(&addr, &addr);
-        while (address < region->start + region->size) {
-            *ppdata = (union value_data *)&region_buf[address - region->start];
-            if (ast_evaluate(ast, &value) && value_is_nonzero(&value)) {
-                if (!hits_add(hits, address, type, *ppdata)) {
-                    region_idx = regions_size;
-                    break;
-                }
+        if (!scan_region(scans, types_size, &hull, region_buf, buf_size,
+                         pages)) {
+            break;
+        }
+    }
+    if (types_size > 1)
+        hits_sort(hits);
+    if (!snapshot && nonstop && (stopped = ramfuck_break(ctx))) {
+        if (!quiet)
+            fprintf(stderr, "verifying %"PRIumax" hits\n", hits->size);
+        /* Invariants hoisted from the running target are hoisted again */
+        for (t = 0; t < types_size; t++) {
+            struct ast *ast;
+            scan_target_invalidate(scans[t].view);
+            if (!(ast = ast_copy(&arena, c[t]->ast, c[t]->symbols + 1))) {
+                errf("search: out-of-memory for AST");
+                goto fail;
             }
-            ops->add(&addr, &align_value, &addr);
-            address += align;
+            ast = ast_hoist(&arena, ast_optimize(&arena, ast));
+            scans[t].ast = ast_cse(&arena, ast);
         }
+        verify_hits(scans, types_size, hits, region_buf, buf_size);
     }
-    ramfuck_continue(ctx);
 
     ret = hits;
     hits = NULL;
 
 fail:
-    if (ast) ast_delete(ast);
-    if (symtab) symbol_table_delete(symtab);
+    if (stopped) ramfuck_continue(ctx);
+    ast_arena_reset(&arena);
+    for (t = 0; t < types_size; t++) {
+        if (c[t]) compiled_release(c[t]);
+        if (scans[t].dedup) dedup_delete(scans[t].dedup);
+        free(scans[t].truth);
+    }
     if (hits) hits_delete(hits);
+    if (snapshot) {
+        /* The target reaps its snapshot child, so stop it meanwhile */
+        int broken = ramfuck_break(ctx);
+        target_detach(snapshot);
+        if (broken) ramfuck_continue(ctx);
+    }
     free(snprint_buf);
     free(region_buf);
-    while (regions_size) region_destroy(&regions[--regions_size]);
+    free(pages);
     free(regions);
     return ret;
 }
 
+/*
+ * Estimate the percentage of values satisfying the expression of a field of
+ * a group search (or above 100 if the expression does not have a predicate
+ * kernel to anchor a scan on). Returns 0 if the expression does not compile.
+ */
+static int group_pass_rate(struct ramfuck *ctx, const struct search_field *f,
+                           unsigned int *out)
+{
+    static const char *const names[] = {"addr", "value"};
+    enum value_type types[2];
+    struct ast_predicate pred;
+    struct ast_arena arena;
+    struct compiled *c;
+    struct ast *ast;
+
+    types[0] = ctx->addr_type;
+    types[1] = value_type_unswapped(f->type);
+    if (!(c = compile(ctx, "group", names, types, 2, ctx->addr_type,
+                      ctx->target, f->expression, NULL, 0))) {
+        return 0;
+    }
+    ast_arena_init(&arena);
+    if ((ast = ast_copy(&arena, c->ast, c->symbols + 1))) {
+        ast = ast_optimize(&arena, ast);
+        *out = (ast_anchor(ast, 2, &pred)
+                && predicate_kernel_of(&pred, 1, f->type)) ? pred.pass_rate
+                                                           : 101;
+    } else {
+        errf("group: out-of-memory for AST");
+    }
+    ast_arena_reset(&arena);
+    compiled_release(c);
+    return ast != NULL;
+}
+
+/*
+ * Expression of field `f` of a group search anchored on field `anchor`, i.e.,
+ * `value` of f is read from addr+(f->offset - anchor->offset) and the base
+ * address is addr-(anchor->offset). The expression is appended to `out`
+ * (of `size` bytes) after `&&` unless it is the first. Returns 1 on success,
+ * 0 if `out` is too small and -1 on lexical errors.
+ */
+static int group_expression(const struct search_field *f,
+                            const struct search_field *anchor,
+                            char *out, size_t size)
+{
+    static const char *const names[] = {"addr", "value"};
+    const char *texts[2];
+    char base[64], value[96];
+    size_t len = strlen(out);
+    int rc;
+
+    texts[0] = texts[1] = NULL;
+    if (anchor->offset) {
+        sprintf(base, "(addr - %"PRIaddru")", anchor->offset);
+        texts[0] = base;
+    }
+    if (f != anchor) {
+        addr_t delta = f->offset - anchor->offset;
+        char sign = (f->offset < anchor->offset) ? '-' : '+';
+        if (sign == '-')
+            delta = anchor->offset - f->offset;
+        sprintf(value, "(*(%s *)(addr %c %"PRIaddru"))",
+                value_type_to_string(f->type), sign, delta);
+        texts[1] = value;
+    }
+
+    if (len + sizeof(" && ()") > size)
+        return 0;
+    if (len) {
+        strcpy(&out[len], " && ");
+        len += 4;
+    }
+    out[len++] = '(';
+    if ((rc = parse_substitute(f->expression, &out[len], size - len - 1,
+                               names, texts, 2)) == 1) {
+        strcat(out, ")");
+    }
+    return rc;
+}
+
+struct hits *search_group(struct ramfuck *ctx,
+                          const struct search_field *fields, size_t n)
+{
+    const struct search_field *anchor;
+    struct hits *hits;
+    unsigned int rate, best;
+    char *text;
+    size_t i, size;
+    umax_t j, k;
+
+    if (!ctx->target) {
+        errf("group: attach to target first");
+        return NULL;
+    }
+
+    /* Anchor on the most selective field (the largest one on ties) */
+    anchor = NULL;
+    best = 0;
+    for (i = 0; i < n; i++) {
+        if (value_type_is_swapped(fields[i].type)) {
+            errf("group: byte-swapped field types are unsupported");
+            return NULL;
+        }
+        if (!group_pass_rate(ctx, &fields[i], &rate))
+            return NULL;
+        if (!anchor || rate < best || (rate == best
+                && value_type_sizeof(fields[i].type)
+                   > value_type_sizeof(anchor->type))) {
+            anchor = &fields[i];
+            best = rate;
+        }
+    }
+    if (!anchor) {
+        errf("group: no fields");
+        return NULL;
+    }
+
+    /* Expression of the anchor field testing the others by dereferences */
+    for (size = 256, text = NULL; ; size *= 2) {
+        char *new;
+        int rc;
+        if (!(new = realloc(text, size))) {
+            errf("group: out-of-memory for expression");
+            free(text);
+            return NULL;
+        }
+        text = new;
+        text[0] = '\0';
+        rc = group_expression(anchor, anchor, text, size);
+        for (i = 0; rc == 1 && i < n; i++) {
+            if (&fields[i] != anchor)
+                rc = group_expression(&fields[i], anchor, text, size);
+        }
+        if (rc < 0) {
+            errf("group: invalid tokens in expression");
+            free(text);
+            return NULL;
+        }
+        if (rc)
+            break;
+    }
+    hits = search(ctx, &anchor->type, 1, text, NULL, 0);
+    free(text);
+    if (!hits)
+        return NULL;
+
+    /* Hits of the anchor are moved to the base address (of the first type) */
+    size = value_type_sizeof((fields[0].type & PTR) ? hits->addr_type
+                                                    : fields[0].type);
+    for (j = k = 0; j < hits->size; j++) {
+        struct hit *hit = &hits->items[j];
+        hit->addr -= anchor->offset;
+        if (anchor->offset || anchor->type != fields[0].type) {
+            hit->type = fields[0].type;
+            if (!ctx->target->read(ctx->target, hit->addr, &hit->prev, size))
+                continue;
+        }
+        hits->items[k++] = *hit;
+    }
+    hits->size = k;
+    hits->value_type = fields[0].type;
+    return hits;
+}
+
+/*
+ * Expression of a filter compiled for hits of a value type.
+ */
+struct filter_type {
+    enum value_type type;
+    struct compiled *c;
+    struct ast *ast;
+    struct value value;
+    union value_data idx, addr, prev, **ppdata;
+    int idx_live, addr_live, prev_live;
+    unsigned char *truth;
+    predicate_kernel kernel;
+    struct ast_predicate pred;
+};
+
 struct hits *filter(struct ramfuck *ctx, struct hits *hits,
-                    const char *expression)
+                    const char *expression,
+                    const struct value *params, size_t params_size)
 {
-    struct symbol_table *symtab;
-    struct parser parser;
-    struct ast *ast, *opt;
+    static const char *const names[] = {"idx", "addr", "value", "prev"};
+    struct filter_type ft[SCAN_TYPES_MAX], *f;
+    size_t n, t, idx_sym, addr_sym, value_sym, prev_sym;
+    struct ast_arena arena;
     struct hits *filtered, *ret;
-    struct value value, result;
-    enum value_type addr_type, value_type;
-    union value_data **ppdata, idx, addr;
+    enum value_type addr_type;
+    struct value result;
+    umax_t i;
 
-    ast = NULL;
-    symtab = NULL;
+    ast_arena_init(&arena);
     filtered = NULL;
-
     ret = hits;
     addr_type = hits->addr_type;
-    value_type = hits->value_type;
-    if ((symtab = symbol_table_new(ctx))) {
-        size_t prev_sym;
-        symbol_table_add(symtab, "idx", addr_type, &idx);
-        symbol_table_add(symtab, "addr", addr_type, &addr);
-        symbol_table_add(symtab, "value", value_type, &value.data);
-        prev_sym = symbol_table_add(symtab, "prev", value_type, NULL);
-        ppdata = &symtab->symbols[prev_sym]->pdata;
-    } else {
-        errf("filter: error creating new symbol table");
-        goto fail;
+
+    /* Hits of each value type are filtered by an expression of their type */
+    for (i = n = 0; i < hits->size; i++) {
+        enum value_type type = hits->items[i].type;
+        for (t = 0; t < n && ft[t].type != type; t++);
+        if (t < n)
+            continue;
+        if (n == SCAN_TYPES_MAX) {
+            errf("filter: too many value types of hits");
+            goto fail;
+        }
+        ft[n].type = type;
+        ft[n].c = NULL;
+        ft[n].truth = NULL;
+        ft[n++].kernel = NULL;
     }
 
-    parser_init(&parser);
-    parser.symtab = symtab;
-    parser.addr_type = addr_type;
-    parser.target = ctx->target;
+    idx_sym = 1;
+    addr_sym = 2;
+    value_sym = 3;
+    prev_sym = 4;
+    for (t = 0; t < n; t++) {
+        enum value_type types[4];
+        struct ast *ast;
+        f = &ft[t];
+        types[0] = types[1] = addr_type;
+        types[2] = types[3] = f->type;
+        if (!(f->c = compile(ctx, "filter", names, types, 4, addr_type,
+                             ctx->target, expression, params, params_size))) {
+            goto fail;
+        }
+        f->c->symtab->symbols[idx_sym]->pdata = &f->idx;
+        f->c->symtab->symbols[addr_sym]->pdata = &f->addr;
+        f->c->symtab->symbols[value_sym]->pdata = &f->value.data;
+        f->ppdata = &f->c->symtab->symbols[prev_sym]->pdata;
+        f->value.type = value_type_unswapped(f->type);
+        if (!(ast = ast_copy(&arena, f->c->ast, f->c->symbols + 1))) {
+            errf("filter: out-of-memory for AST");
+            goto fail;
+        }
+        f->ast = ast_optimize(&arena, ast);
+    }
 
     if ((filtered = hits_new())) {
         filtered->addr_type = addr_type;
-        filtered->value_type = value_type;
+        filtered->value_type = hits->value_type;
     } else {
         errf("filter: error allocating filtered hits container");
         goto fail;
     }
-    if (!(ast = parse_expression(&parser, expression))) {
-        errf("filter: %d parse errors", parser.errors);
-        goto fail;
-    }
-    if ((opt = ast_optimize(ast))) {
-        ast_delete(ast);
-        ast = opt;
-    }
 
     if (!ramfuck_break(ctx))
         goto fail;
+    for (t = 0; t < n; t++) {
+        unsigned long live;
+        size_t size = value_type_sizeof(ft[t].type);
+        f = &ft[t];
+        f->ast = ast_cse(&arena, ast_hoist(&arena, f->ast));
+        live = ast_depends(f->ast);
+        f->idx_live = !!(live & AST_DEPENDS_SYMBOL(idx_sym));
+        f->addr_live = !!(live & AST_DEPENDS_SYMBOL(addr_sym));
+        f->prev_live = !!(live & AST_DEPENDS_SYMBOL(prev_sym));
+
+        /* Truth table pays off only if there are more hits than entries */
+        if (size <= 2 && hits->size > (umax_t)1 << (8 * size)
+                && !(live & ~AST_DEPENDS_SYMBOL(value_sym))) {
+            f->truth = truth_table_new(f->ast, f->type, &f->value.data);
+        }
+        if (!f->truth) {
+            f->kernel = predicate_kernel_new(f->ast, value_sym, 0, f->type,
+                                             &f->pred);
+        }
+    }
 
-    idx.umax = 0;
-    while (idx.umax < hits->size) {
+    for (i = 0, f = ft; i < hits->size; i++) {
         size_t size;
-        umax_t i = idx.umax++;
-        addr.addr = hits->items[i].addr;
-        value.type = hits->items[i].type;
-        size = value_type_sizeof((value.type & PTR) ? addr_type : value.type);
-        if (!ctx->target->read(ctx->target, addr.addr, &value.data, size))
+        union value_data data;
+        addr_t address = hits->items[i].addr;
+        if (f->type != hits->items[i].type) {
+            for (f = ft; f->type != hits->items[i].type; f++);
+        }
+        size = value_type_sizeof((f->type & PTR) ? addr_type : f->type);
+        if (!ctx->target->read(ctx->target, address, &data, size))
+            continue;
+
+        if (f->truth) {
+            uint16_t x = (size == 1) ? data.u8 : data.u16;
+            if (truth_table_test(f->truth, x)) {
+                if (!hits_add(filtered, address, f->type, &data))
+                    break;
+            }
             continue;
+        }
 
-        *ppdata = &hits->items[i].prev;
-        if (ast_evaluate(ast, &result) && value_is_nonzero(&result)) {
-            if (!hits_add(filtered, addr.addr, value_type, &value.data))
+        if (f->kernel) {
+            if (!f->kernel(&f->pred, filtered, f->type, (const char *)&data,
+                           address, address, address + 1, 1)) {
+                break;
+            }
+            continue;
+        }
+
+        /* Only symbols referenced by the expression are updated */
+        f->value.data = data;
+        if (f->idx_live)
+            f->idx.umax = i + 1;
+        if (f->addr_live)
+            f->addr.addr = address;
+        if (f->prev_live)
+            *f->ppdata = &hits->items[i].prev;
+        if (value_type_is_swapped(f->type)) {
+            value_data_swap(&f->value.data, size);
+            if (f->prev_live) {
+                f->prev = hits->items[i].prev;
+                value_data_swap(&f->prev, size);
+                *f->ppdata = &f->prev;
+            }
+        }
+        if (ast_evaluate(f->ast, &result) && value_is_nonzero(&result)) {
+            if (!hits_add(filtered, address, f->type, &data))
                 break;
         }
     }
@@ -271,7 +2189,10 @@ struct hits *filter(struct ramfuck *ctx, struct hits *hits,
 
 fail:
     if (filtered) hits_delete(filtered);
-    if (ast) ast_delete(ast);
-    if (symtab) symbol_table_delete(symtab);
+    ast_arena_reset(&arena);
+    for (t = 0; t < n; t++) {
+        if (ft[t].c) compiled_release(ft[t].c);
+        free(ft[t].truth);
+    }
     return ret;
 }
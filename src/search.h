@@ -5,17 +5,59 @@
 #include "hits.h"
 
 /*
- * Search a value of type 'type' from a process specified by 'pid'.
- * Returns a hits structure representing the hits.
+ * Search values of types 'types' from the target of 'ctx' in a single pass.
+ * Parameters $1, $2, ... of the expression are bound to params[0], ...
+ * Returns a hits structure representing the hits (of mixed types if more
+ * than one type is given).
  */
-struct hits *search(struct ramfuck *ctx, enum value_type type,
-                    const char *expression);
+struct hits *search(struct ramfuck *ctx,
+                    const enum value_type *types, size_t types_size,
+                    const char *expression,
+                    const struct value *params, size_t params_size);
+
+/*
+ * Field of a group search, i.e., a value of type `type` at `offset` bytes
+ * from the base address satisfying `expression` of symbols `addr` (the base
+ * address) and `value` (the field).
+ */
+struct search_field {
+    addr_t offset;
+    enum value_type type;
+    const char *expression;
+};
+
+/*
+ * Search groups of values (such as fields of a struct) from the target of
+ * 'ctx'. Memory is scanned for the field of the most selective expression,
+ * and the other fields are verified from the same memory. Returns hits at
+ * the base addresses typed by the first field.
+ */
+struct hits *search_group(struct ramfuck *ctx,
+                          const struct search_field *fields, size_t n);
 
 /*
  * Filter results of a previous search.
+ * Parameters $1, $2, ... of the expression are bound to params[0], ...
  * Returns a filtered set of hits.
  */
 struct hits *filter(struct ramfuck *ctx, struct hits *hits,
-                    const char *expression);
+                    const char *expression,
+                    const struct value *params, size_t params_size);
+
+/*
+ * Prepare a named expression with parameters $1, $2, ...
+ * Returns non-zero on success.
+ */
+int prepare(struct ramfuck *ctx, const char *name, size_t len,
+            const char *expression);
+
+/* Expression prepared with a name (NULL if none) */
+const char *prepared(struct ramfuck *ctx, const char *name, size_t len);
+
+/* Drop cached compiled expressions (e.g., when the target changes) */
+void compiled_flush(struct ramfuck *ctx);
+
+/* Delete prepared expressions and cached compiled expressions */
+void prepared_clear(struct ramfuck *ctx);
 
 #endif
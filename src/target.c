@@ -16,8 +16,16 @@
 
 struct target_process {
     struct target base;
-    pid_t pid;
+    pid_t pid, parent; /* parent reaps a snapshot process (0 otherwise) */
     int mem_fd;
+
+    /* Cached region table and the /proc/pid/maps text it was parsed from */
+    int maps_fd, pagemap_fd;
+    struct region_table *table;
+    struct maps_text {
+        char *data;
+        size_t size, capacity;
+    } maps[2];
 };
 
 static int pread_buffer(int fd, off_t offset, void *buf, size_t len)
@@ -60,6 +68,33 @@ static int pwrite_buffer(int fd, off_t offset, void *buf, size_t len)
     return !len;
 }
 
+static void process_init_regions(struct target_process *process)
+{
+    process->maps_fd = -1;
+    process->pagemap_fd = -1;
+    process->table = NULL;
+    memset(process->maps, 0, sizeof(process->maps));
+}
+
+static void process_destroy_regions(struct target_process *process)
+{
+    if (process->maps_fd != -1) {
+        close(process->maps_fd);
+        process->maps_fd = -1;
+    }
+    if (process->pagemap_fd != -1) {
+        close(process->pagemap_fd);
+        process->pagemap_fd = -1;
+    }
+    if (process->table) {
+        region_table_delete(process->table);
+        process->table = NULL;
+    }
+    free(process->maps[0].data);
+    free(process->maps[1].data);
+    memset(process->maps, 0, sizeof(process->maps));
+}
+
 static int process_detach(struct target *target)
 {
     struct target_process *process = (struct target_process *)target;
@@ -71,6 +106,7 @@ static int process_detach(struct target *target)
         close(process->mem_fd);
         process->mem_fd = -1;
     } else rc = 0;
+    process_destroy_regions(process);
     free(process);
     return rc;
 }
@@ -87,79 +123,154 @@ int process_run(struct target *target)
     return ptrace_detach(process->pid);
 }
 
-struct process_region_iter {
-    struct region region;
-    char pathbuf[4096];
-    FILE* fd;
-};
+static int snapshot_detach(struct target *target)
+{
+    struct target_process *snapshot = (struct target_process *)target;
+    int rc = ptrace_reap(snapshot->parent, snapshot->pid);
+    if (snapshot->mem_fd != -1)
+        close(snapshot->mem_fd);
+    process_destroy_regions(snapshot);
+    free(snapshot);
+    return rc;
+}
 
-/*
- * /proc/pid/maps format:
- * address           perms offset  dev   inode   pathname
- * 00400000-00580000 r-xp 00000000 fe:01 4858009 /usr/lib/nethack/nethack
- */
-static struct region *process_region_iter_next(struct region *it)
-{
-    if (it) {
-        char range[256];
-        addr_t start, end;
-        if (fscanf(((struct process_region_iter *)it)->fd, "%255[^ ]", range)) {
-            char *p = strchr(range, '-');
-            if (p && strlen(p+1 + strspn(p+1, "0")) * 4 <= ADDR_BITS) {
-                char perms[4];
-                *((struct process_region_iter *)it)->pathbuf = '\0';
-                if (sscanf(range, "%" SCNaddr "-%" SCNaddr, &start, &end) == 2
-                 && fscanf(((struct process_region_iter *)it)->fd,
-                           " %c%c%c%c %*[^ ] %*[^ ] %*[^ ]%*[ ]%4095[^\n]",
-                           &perms[0], &perms[1], &perms[2], &perms[3],
-                           ((struct process_region_iter *)it)->pathbuf) >= 4) {
-                    it->start = start;
-                    it->size = end - start;
-                    it->prot = 0;
-                    if (perms[0] == 'r') it->prot |= MEM_READ;
-                    if (perms[1] == 'w') it->prot |= MEM_WRITE;
-                    if (perms[2] == 'x') it->prot |= MEM_EXECUTE;
-                    it->path = ((struct process_region_iter *)it)->pathbuf;
-                    it->path += isspace(*it->path);
-                    if (!*it->path)
-                        it->path = NULL;
-                    return it;
-                } else {
-                    errf("target: invalid /proc/pid/maps format");
-                }
-            } else if (p) {
-                warnf("target: process memory addresses exceed supported "
-                      "%u bits", (unsigned int)ADDR_BITS);
-            }
+static int snapshot_stop(struct target *target)
+{
+    return 1;
+}
+
+static int snapshot_run(struct target *target)
+{
+    return 1;
+}
+
+static struct target *snapshot_snapshot(struct target *target)
+{
+    return NULL;
+}
+
+static int snapshot_write(struct target *target, addr_t addr, void *buf,
+                          size_t len)
+{
+    return 0;
+}
+
+static int read_maps_text(int fd, struct maps_text *text)
+{
+    text->size = 0;
+    if (lseek(fd, 0, SEEK_SET) == -1)
+        return 0;
+    while (1) {
+        ssize_t ret;
+        if (text->capacity - text->size < 4096) {
+            size_t capacity = text->capacity ? 2*text->capacity : 16384;
+            char *new = realloc(text->data, capacity);
+            if (!new)
+                return 0;
+            text->data = new;
+            text->capacity = capacity;
+        }
+        ret = read(fd, text->data + text->size, text->capacity - text->size);
+        if (ret > 0) {
+            text->size += ret;
+        } else if (ret == 0) {
+            return 1;
+        } else if (errno != EINTR) {
+            return 0;
         }
-        fclose(((struct process_region_iter *)it)->fd);
-        free(it);
-        it = NULL;
     }
-    return NULL;
 }
 
-static struct region *process_region_iter_first(struct target *target)
+/*
+ * The region table is parsed only if /proc/pid/maps text has changed since
+ * the previous call, which is much cheaper than parsing large maps.
+ */
+static struct region_table *process_regions(struct target *target)
 {
-    struct process_region_iter *it;
+    struct maps_text text;
     struct target_process *process = (struct target_process *)target;
-    if ((it = malloc(sizeof(struct process_region_iter)))) {
-        char filename[128];
-        it->region.path = it->pathbuf;
 
+    if (process->maps_fd == -1) {
+        char filename[128];
         if (process->pid > 0) {
             sprintf(filename, "/proc/%lu/maps", (unsigned long)process->pid);
         } else {
             memcpy(filename, "/proc/self/maps", sizeof("/proc/self/maps"));
         }
-
-        if (!(it->fd = fopen(filename, "r"))) {
+        if ((process->maps_fd = open(filename, O_RDONLY)) == -1) {
             errf("target: error opening %s", filename);
-            free(it);
-            it = NULL;
+            return NULL;
+        }
+    }
+
+    if (!process->table && !(process->table = region_table_new())) {
+        errf("target: out-of-memory for region table");
+        return NULL;
+    }
+
+    if (!read_maps_text(process->maps_fd, &process->maps[1])) {
+        errf("target: error reading memory maps of process %lu",
+             (unsigned long)process->pid);
+        return NULL;
+    }
+
+    if (process->table->generation
+            && process->maps[1].size == process->maps[0].size
+            && !memcmp(process->maps[1].data, process->maps[0].data,
+                       process->maps[0].size)) {
+        process->table->changes_size = 0;
+        return process->table;
+    }
+
+    if (!region_table_parse_maps(process->table, process->maps[1].data,
+                                 process->maps[1].size)) {
+        return NULL;
+    }
+
+    text = process->maps[0];
+    process->maps[0] = process->maps[1];
+    process->maps[1] = text;
+    return process->table;
+}
+
+/*
+ * Page residency is read from /proc/pid/pagemap (64-bit entry per page, bit
+ * 63 for present and bit 62 for swapped pages).
+ */
+static int process_pages(struct target *target, addr_t addr, size_t len,
+                         unsigned char *out)
+{
+    uint64_t entries[512];
+    size_t page_size, pages, i, n;
+    struct target_process *process = (struct target_process *)target;
+
+    if (process->pagemap_fd == -1) {
+        char filename[128];
+        sprintf(filename, "/proc/%lu/pagemap", (unsigned long)process->pid);
+        if ((process->pagemap_fd = open(filename, O_RDONLY)) == -1)
+            return 0;
+    }
+
+    page_size = target_page_size();
+    pages = (len + page_size-1) / page_size;
+    addr /= page_size;
+    for (i = 0; i < pages; i += n) {
+        size_t j;
+        off_t offset = (off_t)((addr + i) * sizeof(uint64_t));
+        if ((addr + i) * sizeof(uint64_t) != (addr_t)offset)
+            return 0;
+        if ((n = pages - i) > sizeof(entries) / sizeof(uint64_t))
+            n = sizeof(entries) / sizeof(uint64_t);
+        if (!pread_buffer(process->pagemap_fd, offset, entries,
+                          n * sizeof(uint64_t))) {
+            return 0;
+        }
+        for (j = 0; j < n; j++) {
+            out[i + j] = ((entries[j] >> 63) & 1) ? MEM_PAGE_PRESENT
+                       : ((entries[j] >> 62) & 1) ? MEM_PAGE_SWAPPED : 0;
         }
     }
-    return it ? process_region_iter_next((struct region *)it) : NULL;
+    return 1;
 }
 
 static int process_ptrace_read(struct target_process *process,
@@ -199,14 +310,58 @@ static int process_write(struct target *target, addr_t addr, void *buf,
     return 0;
 }
 
+/*
+ * Snapshot is a forked child of the process. The child stays ptrace-stopped
+ * (never runs) until killed by detach, and its writes are rejected. The
+ * process must be stopped on detach in order to reap the child.
+ */
+static struct target *process_snapshot(struct target *target)
+{
+    static const struct target snapshot_init = {
+        snapshot_detach,
+        snapshot_stop,
+        snapshot_run,
+        snapshot_snapshot,
+        process_regions,
+        process_pages,
+        process_read,
+        snapshot_write
+    };
+
+    pid_t child;
+    struct target_process *snapshot;
+    struct target_process *process = (struct target_process *)target;
+    if (!(child = ptrace_fork(process->pid))) {
+        errf("target: forking a snapshot of process %lu failed",
+             (unsigned long)process->pid);
+        return NULL;
+    }
+
+    if ((snapshot = malloc(sizeof(struct target_process)))) {
+        char mem_path[128];
+        memcpy(snapshot, &snapshot_init, sizeof(struct target));
+        snapshot->pid = child;
+        snapshot->parent = process->pid;
+        process_init_regions(snapshot);
+        sprintf(mem_path, "/proc/%lu/mem", (unsigned long)child);
+        if ((snapshot->mem_fd = open(mem_path, O_RDONLY)) == -1)
+            warnf("target: open(%s) failed", mem_path);
+    } else {
+        errf("target: out-of-memory for snapshot target instance");
+        ptrace_reap(process->pid, child);
+    }
+    return (struct target *)snapshot;
+}
+
 static struct target *target_attach_pid(pid_t pid)
 {
     static const struct target process_init = {
         process_detach,
         process_stop,
         process_run,
-        process_region_iter_first,
-        process_region_iter_next,
+        process_snapshot,
+        process_regions,
+        process_pages,
         process_read,
         process_write
     };
@@ -217,6 +372,8 @@ static struct target *target_attach_pid(pid_t pid)
             char mem_path[128];
             memcpy(process, &process_init, sizeof(struct target));
             process->pid = pid;
+            process->parent = 0;
+            process_init_regions(process);
             sprintf(mem_path, "/proc/%lu/mem", (unsigned long)pid);
             if ((process->mem_fd = open(mem_path, O_RDWR)) == -1) {
                 if ((process->mem_fd = open(mem_path, O_RDONLY)) == -1)
@@ -238,6 +395,7 @@ struct target_file {
     int rw;
     off_t size;
     char *path;
+    struct region_table *table;
 };
 
 static int file_detach(struct target *target)
@@ -251,6 +409,10 @@ static int file_detach(struct target *target)
         free(file->path);
         file->path = NULL;
     }
+    if (file->table) {
+        region_table_delete(file->table);
+        file->table = NULL;
+    }
     free(file);
     return 1;
 }
@@ -265,30 +427,38 @@ int file_run(struct target *target)
     return 1;
 }
 
-static struct region *file_region_first(struct target *target)
+static struct target *file_snapshot(struct target *target)
 {
-    struct region *it;
-    if ((it = malloc(sizeof(struct region)))) {
-        size_t size;
-        struct target_file *file = (struct target_file *)target;
-        it->start = 0;
-        it->size = file->size;
-        it->prot = file->rw ? (MEM_READ|MEM_WRITE) : MEM_READ;
-        if ((size = strlen(file->path)) && ++size) {
-            if ((it->path = malloc(size)))
-                memcpy(it->path, file->path, size);
-        } else {
-            it->path = NULL;
+    return NULL;
+}
+
+static struct region_table *file_regions(struct target *target)
+{
+    struct target_file *file = (struct target_file *)target;
+    if (!file->table) {
+        struct region region;
+        if (!(file->table = region_table_new())) {
+            errf("target: out-of-memory for region table");
+            return NULL;
         }
+        region.start = 0;
+        region.size = file->size;
+        region.prot = file->rw ? (MEM_READ|MEM_WRITE) : MEM_READ;
+        region.path = file->path;
+        if (!region_table_update(file->table, &region, 1)) {
+            region_table_delete(file->table);
+            file->table = NULL;
+        }
+    } else {
+        file->table->changes_size = 0;
     }
-    return it;
+    return file->table;
 }
 
-static struct region *file_region_next(struct region *it)
+static int file_pages(struct target *target, addr_t addr, size_t len,
+                      unsigned char *out)
 {
-    free(it->path);
-    free(it);
-    return NULL;
+    return 0;
 }
 
 static int file_read(struct target *target, addr_t addr, void *buf, size_t len)
@@ -309,8 +479,9 @@ static struct target *target_attach_file(const char *path)
         file_detach,
         file_stop,
         file_run,
-        file_region_first,
-        file_region_next,
+        file_snapshot,
+        file_regions,
+        file_pages,
         file_read,
         file_write
     };
@@ -324,6 +495,7 @@ static struct target *target_attach_file(const char *path)
                 file->fd = fd;
                 file->rw = rw;
                 file->size = sz;
+                file->table = NULL;
                 if ((sz = strlen(path)) && ++sz) {
                     if ((file->path = malloc(sz)))
                         memcpy(file->path, path, sz);
@@ -374,6 +546,303 @@ void target_detach(struct target *target)
     target->detach(target);
 }
 
+/*
+ * LRU page cache target. Cached pages are kept in a doubly-linked list in
+ * the order of use (head is the most recently used page) and are looked up
+ * from a chained hash table.
+ */
+#define CACHE_NIL ((size_t)-1)
+#define CACHE_NO_PAGE ((addr_t)1) /* Entry not holding a page */
+
+struct target_cache {
+    struct target base;
+    struct target *target;
+    int stopped;
+
+    size_t page_size;
+    size_t size, capacity;
+    char *data;
+    struct cache_entry {
+        addr_t page;
+        size_t prev, next; /* LRU list */
+        size_t chain;      /* Hash chain */
+    } *entries;
+    size_t *buckets, buckets_size;
+    size_t head, tail;
+
+    unsigned long hits, misses;
+};
+
+static size_t cache_bucket(struct target_cache *cache, addr_t page)
+{
+    return (size_t)((page / cache->page_size) * 2654435761UL)
+         % cache->buckets_size;
+}
+
+static void cache_invalidate(struct target_cache *cache)
+{
+    size_t i;
+    for (i = 0; i < cache->buckets_size; i++)
+        cache->buckets[i] = CACHE_NIL;
+    cache->size = 0;
+    cache->head = cache->tail = CACHE_NIL;
+}
+
+static void cache_unlink(struct target_cache *cache, size_t i)
+{
+    struct cache_entry *entry = &cache->entries[i];
+    if (entry->prev != CACHE_NIL) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if (entry->next != CACHE_NIL) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+static void cache_push(struct target_cache *cache, size_t i)
+{
+    struct cache_entry *entry = &cache->entries[i];
+    entry->prev = CACHE_NIL;
+    entry->next = cache->head;
+    if (cache->head != CACHE_NIL) {
+        cache->entries[cache->head].prev = i;
+    } else {
+        cache->tail = i;
+    }
+    cache->head = i;
+}
+
+static size_t cache_find(struct target_cache *cache, addr_t page)
+{
+    size_t i = cache->buckets[cache_bucket(cache, page)];
+    while (i != CACHE_NIL && cache->entries[i].page != page)
+        i = cache->entries[i].chain;
+    return i;
+}
+
+/* Get a cached page, reading (and evicting the least recently used) page */
+static char *cache_page(struct target_cache *cache, addr_t page)
+{
+    size_t i, *link;
+    struct cache_entry *entry;
+
+    if ((i = cache_find(cache, page)) != CACHE_NIL) {
+        cache->hits++;
+        if (i != cache->head) {
+            cache_unlink(cache, i);
+            cache_push(cache, i);
+        }
+        return &cache->data[i * cache->page_size];
+    }
+    cache->misses++;
+
+    if (cache->size < cache->capacity) {
+        i = cache->size++;
+    } else {
+        i = cache->tail;
+        cache_unlink(cache, i);
+        if (cache->entries[i].page != CACHE_NO_PAGE) {
+            link = &cache->buckets[cache_bucket(cache,
+                                                cache->entries[i].page)];
+            while (*link != i)
+                link = &cache->entries[*link].chain;
+            *link = cache->entries[i].chain;
+        }
+    }
+    entry = &cache->entries[i];
+
+    if (!cache->target->read(cache->target, page,
+                             &cache->data[i * cache->page_size],
+                             cache->page_size)) {
+        /* Unused entries are recycled first from the tail of the list */
+        if (cache->tail != CACHE_NIL) {
+            entry->prev = cache->tail;
+            entry->next = CACHE_NIL;
+            cache->entries[cache->tail].next = i;
+            cache->tail = i;
+        } else {
+            cache_push(cache, i);
+        }
+        entry->page = CACHE_NO_PAGE;
+        entry->chain = CACHE_NIL;
+        return NULL;
+    }
+
+    entry->page = page;
+    link = &cache->buckets[cache_bucket(cache, page)];
+    entry->chain = *link;
+    *link = i;
+    cache_push(cache, i);
+    return &cache->data[i * cache->page_size];
+}
+
+static int cache_detach(struct target *target)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    int rc = cache->target->detach(cache->target);
+    free(cache->data);
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+    return rc;
+}
+
+static int cache_stop(struct target *target)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    return (cache->stopped = cache->target->stop(cache->target));
+}
+
+static int cache_run(struct target *target)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    cache_invalidate(cache);
+    cache->stopped = 0;
+    return cache->target->run(cache->target);
+}
+
+static struct target *cache_snapshot(struct target *target)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    return cache->target->snapshot(cache->target);
+}
+
+static struct region_table *cache_regions(struct target *target)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    return cache->target->regions(cache->target);
+}
+
+static int cache_pages(struct target *target, addr_t addr, size_t len,
+                       unsigned char *out)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    return cache->target->pages(cache->target, addr, len, out);
+}
+
+static int cache_read(struct target *target, addr_t addr, void *buf,
+                      size_t len)
+{
+    char *out = buf;
+    struct target_cache *cache = (struct target_cache *)target;
+
+    if (!cache->stopped || len > cache->page_size)
+        return cache->target->read(cache->target, addr, buf, len);
+
+    while (len > 0) {
+        char *data;
+        addr_t page = addr - addr % cache->page_size;
+        size_t n = cache->page_size - (size_t)(addr - page);
+        if (n > len)
+            n = len;
+        if (!(data = cache_page(cache, page)))
+            return cache->target->read(cache->target, addr, out, len);
+        memcpy(out, &data[addr - page], n);
+        addr += n;
+        out += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/* Writes go through to the target and update the cached pages */
+static int cache_write(struct target *target, addr_t addr, void *buf,
+                       size_t len)
+{
+    const char *in = buf;
+    struct target_cache *cache = (struct target_cache *)target;
+
+    if (!cache->target->write(cache->target, addr, buf, len))
+        return 0;
+
+    while (len > 0) {
+        size_t i;
+        addr_t page = addr - addr % cache->page_size;
+        size_t n = cache->page_size - (size_t)(addr - page);
+        if (n > len)
+            n = len;
+        if ((i = cache_find(cache, page)) != CACHE_NIL)
+            memcpy(&cache->data[i*cache->page_size + (addr - page)], in, n);
+        addr += n;
+        in += n;
+        len -= n;
+    }
+    return 1;
+}
+
+struct target *target_cache_new(struct target *target, size_t pages)
+{
+    static const struct target cache_init = {
+        cache_detach,
+        cache_stop,
+        cache_run,
+        cache_snapshot,
+        cache_regions,
+        cache_pages,
+        cache_read,
+        cache_write
+    };
+
+    struct target_cache *cache;
+    size_t page_size = target_page_size();
+    if (pages > (size_t)-1 / page_size
+            || pages > (size_t)-1 / sizeof(struct cache_entry)
+            || pages > (size_t)-1 / (2*sizeof(size_t))) {
+        errf("target: too many cache pages (%lu)", (unsigned long)pages);
+        return NULL;
+    }
+    if (!(cache = calloc(1, sizeof(struct target_cache)))) {
+        errf("target: out-of-memory for page cache");
+        return NULL;
+    }
+    memcpy(cache, &cache_init, sizeof(struct target));
+    cache->target = target;
+    cache->page_size = page_size;
+    cache->capacity = pages;
+    cache->buckets_size = 2*pages;
+    cache->data = malloc(pages * cache->page_size);
+    cache->entries = malloc(pages * sizeof(struct cache_entry));
+    cache->buckets = malloc(cache->buckets_size * sizeof(size_t));
+    if (!cache->data || !cache->entries || !cache->buckets) {
+        errf("target: out-of-memory for %lu cache pages",
+             (unsigned long)pages);
+        free(cache->data);
+        free(cache->entries);
+        free(cache->buckets);
+        free(cache);
+        return NULL;
+    }
+    cache_invalidate(cache);
+    return (struct target *)cache;
+}
+
+int target_cache_stats(struct target *target, size_t *size, size_t *capacity,
+                       unsigned long *hits, unsigned long *misses)
+{
+    struct target_cache *cache = (struct target_cache *)target;
+    if (target->detach != cache_detach)
+        return 0;
+    *size = cache->size;
+    *capacity = cache->capacity;
+    *hits = cache->hits;
+    *misses = cache->misses;
+    return 1;
+}
+
+size_t target_page_size()
+{
+    static size_t page_size;
+    if (!page_size) {
+        long ret = sysconf(_SC_PAGESIZE);
+        page_size = (ret > 0) ? (size_t)ret : 4096;
+    }
+    return page_size;
+}
+
 size_t region_snprint(const struct region *mr, char *out, size_t size)
 {
     char suffix;
@@ -414,22 +883,318 @@ size_t region_snprint(const struct region *mr, char *out, size_t size)
                     mr->path ? mr->path : "");
 }
 
-int region_copy(struct region *dest, const struct region *source)
+struct region_table *region_table_new()
 {
-    memcpy(dest, source, sizeof(struct region));
-    if (source->path) {
-        size_t size = strlen(source->path) + 1;
-        if (!size || !(dest->path = malloc(size))) {
-            errf("target: allocating path buffer for copied region failed");
+    struct region_table *table;
+    if ((table = calloc(1, sizeof(struct region_table))))
+        table->generation = 0;
+    return table;
+}
+
+void region_table_delete(struct region_table *table)
+{
+    size_t i;
+    for (i = 0; i < table->paths_capacity; i++)
+        free(table->paths[i]);
+    free(table->paths);
+    free(table->changes);
+    free(table->regions);
+    free(table->index);
+    free(table);
+}
+
+static size_t path_hash(const char *path, size_t len)
+{
+    size_t i, hash = 2166136261UL;
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)path[i]) * 16777619UL;
+    return hash;
+}
+
+/*
+ * Intern a path of length `len` into an open addressing hash table of paths.
+ */
+static char *region_table_intern(struct region_table *table,
+                                 const char *path, size_t len)
+{
+    size_t i, mask;
+    if (!path || !len)
+        return NULL;
+
+    if (2*(table->paths_size + 1) > table->paths_capacity) {
+        char **paths;
+        size_t j, capacity = table->paths_capacity ? 2*table->paths_capacity
+                                                   : 64;
+        if (!(paths = calloc(capacity, sizeof(char *)))) {
+            errf("target: out-of-memory for interned region paths");
+            return NULL;
+        }
+        for (j = 0; j < table->paths_capacity; j++) {
+            if (table->paths[j]) {
+                const char *old = table->paths[j];
+                i = path_hash(old, strlen(old)) & (capacity - 1);
+                while (paths[i]) i = (i + 1) & (capacity - 1);
+                paths[i] = table->paths[j];
+            }
+        }
+        free(table->paths);
+        table->paths = paths;
+        table->paths_capacity = capacity;
+    }
+
+    mask = table->paths_capacity - 1;
+    for (i = path_hash(path, len) & mask; table->paths[i]; i = (i+1) & mask) {
+        if (!strncmp(table->paths[i], path, len) && !table->paths[i][len])
+            return table->paths[i];
+    }
+    if ((table->paths[i] = malloc(len + 1))) {
+        memcpy(table->paths[i], path, len);
+        table->paths[i][len] = '\0';
+        table->paths_size++;
+    } else {
+        errf("target: out-of-memory for interned region path");
+    }
+    return table->paths[i];
+}
+
+static int region_table_change(struct region_table *table,
+                               enum region_change_type type,
+                               const struct region *region, addr_t old_size)
+{
+    struct region_change *change;
+    if (table->changes_size == table->changes_capacity) {
+        size_t capacity = table->changes_capacity ? 2*table->changes_capacity
+                                                  : 64;
+        change = realloc(table->changes, capacity * sizeof(*change));
+        if (!change) {
+            errf("target: out-of-memory for region table changes");
             return 0;
         }
-        memcpy(dest->path, source->path, size);
+        table->changes = change;
+        table->changes_capacity = capacity;
     }
+    change = &table->changes[table->changes_size++];
+    change->type = type;
+    change->region = *region;
+    change->old_size = old_size;
     return 1;
 }
 
-void region_destroy(struct region *region)
+/*
+ * Replace regions of the table with new sorted regions (with interned paths).
+ *
+ * Takes ownership of `regions` array. The differences between the old and
+ * the new regions are found by merging the two sorted arrays.
+ */
+static int region_table_commit(struct region_table *table,
+                               struct region *regions, size_t size,
+                               size_t capacity)
 {
-    free(region->path);
-    memset(region, 0, sizeof(struct region));
+    size_t i, j;
+    struct region *old = table->regions;
+    table->changes_size = 0;
+    for (i = j = 0; i < table->size || j < size; ) {
+        int ok;
+        if (j == size || (i < table->size && old[i].start < regions[j].start)) {
+            ok = region_table_change(table, REGION_REMOVED, &old[i++], 0);
+        } else if (i == table->size || regions[j].start < old[i].start) {
+            ok = region_table_change(table, REGION_ADDED, &regions[j++], 0);
+        } else if (old[i].prot != regions[j].prot
+                || old[i].path != regions[j].path) {
+            ok = region_table_change(table, REGION_REMOVED, &old[i++], 0)
+              && region_table_change(table, REGION_ADDED, &regions[j++], 0);
+        } else if (old[i].size != regions[j].size) {
+            ok = region_table_change(table, REGION_RESIZED, &regions[j++],
+                                     old[i++].size);
+        } else {
+            ok = 1;
+            i++;
+            j++;
+        }
+        if (!ok) {
+            table->changes_size = 0;
+            free(regions);
+            return 0;
+        }
+    }
+
+    if (!table->changes_size && table->generation) {
+        free(regions);
+        return 1;
+    }
+
+    free(table->regions);
+    table->regions = regions;
+    table->size = size;
+    table->capacity = capacity;
+    table->generation++;
+    return 1;
+}
+
+int region_table_update(struct region_table *table,
+                        const struct region *regions, size_t size)
+{
+    size_t i;
+    struct region *new;
+    if (!(new = malloc((size ? size : 1) * sizeof(struct region)))) {
+        errf("target: out-of-memory for region table");
+        return 0;
+    }
+    for (i = 0; i < size; i++) {
+        new[i] = regions[i];
+        new[i].path = NULL;
+        if (regions[i].path && *regions[i].path) {
+            size_t len = strlen(regions[i].path);
+            new[i].path = region_table_intern(table, regions[i].path, len);
+            if (!new[i].path) {
+                free(new);
+                return 0;
+            }
+        }
+    }
+    return region_table_commit(table, new, size, size);
+}
+
+/*
+ * Parse hexadecimal address and return the number of its significant digits.
+ */
+static int parse_hex_addr(const char **pp, const char *end, addr_t *out)
+{
+    int digits = 0;
+    const char *p = *pp;
+    for (*out = 0; p < end && isxdigit(*p); p++) {
+        int c = *p;
+        int val = (c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10;
+        if (digits || val) {
+            if (++digits * 4 > ADDR_BITS)
+                continue;
+            *out = (*out << 4) | val;
+        }
+    }
+    if (p == *pp)
+        return -1;
+    *pp = p;
+    return digits;
+}
+
+/*
+ * /proc/pid/maps format:
+ * address           perms offset  dev   inode   pathname
+ * 00400000-00580000 r-xp 00000000 fe:01 4858009 /usr/lib/nethack/nethack
+ */
+int region_table_parse_maps(struct region_table *table,
+                            const char *text, size_t len)
+{
+    const char *p, *end;
+    struct region *regions;
+    size_t size, capacity;
+
+    size = 0;
+    capacity = table->capacity ? table->capacity : 64;
+    if (!(regions = malloc(capacity * sizeof(struct region)))) {
+        errf("target: out-of-memory for region table");
+        return 0;
+    }
+
+    for (p = text; p < text + len; p = end + 1) {
+        int i, digits[2];
+        addr_t start, stop;
+        struct region *region;
+        const char *line = p;
+        if (!(end = memchr(p, '\n', (text + len) - p)))
+            end = text + len;
+
+        digits[0] = parse_hex_addr(&p, end, &start);
+        if (digits[0] < 0 || p == end || *p++ != '-'
+                || (digits[1] = parse_hex_addr(&p, end, &stop)) < 0
+                || end - p < 5 || *p++ != ' ') {
+            errf("target: invalid /proc/pid/maps format '%.*s'",
+                 (int)(end - line), line);
+            free(regions);
+            return 0;
+        }
+        if (digits[0] * 4 > ADDR_BITS || digits[1] * 4 > ADDR_BITS) {
+            warnf("target: process memory addresses exceed supported "
+                  "%u bits", (unsigned int)ADDR_BITS);
+            break;
+        }
+
+        if (size == capacity) {
+            struct region *new;
+            new = realloc(regions, 2 * capacity * sizeof(struct region));
+            if (!new) {
+                errf("target: out-of-memory for region table");
+                free(regions);
+                return 0;
+            }
+            regions = new;
+            capacity *= 2;
+        }
+        region = &regions[size++];
+        region->start = start;
+        region->size = stop - start;
+        region->prot = 0;
+        if (p[0] == 'r') region->prot |= MEM_READ;
+        if (p[1] == 'w') region->prot |= MEM_WRITE;
+        if (p[2] == 'x') region->prot |= MEM_EXECUTE;
+        p += 4;
+
+        /* Skip offset, dev and inode */
+        for (i = 0; i < 3; i++) {
+            while (p < end && *p == ' ') p++;
+            while (p < end && *p != ' ') p++;
+        }
+        while (p < end && isspace(*p)) p++;
+        region->path = NULL;
+        if (p < end && !(region->path = region_table_intern(table, p, end-p))) {
+            free(regions);
+            return 0;
+        }
+    }
+
+    return region_table_commit(table, regions, size, capacity);
+}
+
+/*
+ * Fill Eytzinger (BFS order) layout of the sorted regions recursively.
+ */
+static size_t region_index_fill(struct region_table *table, size_t i, size_t k)
+{
+    if (k <= table->size) {
+        i = region_index_fill(table, i, 2*k);
+        table->index[k].start = table->regions[i].start;
+        table->index[k].end = table->regions[i].start + table->regions[i].size;
+        table->index[k].region = i++;
+        i = region_index_fill(table, i, 2*k + 1);
+    }
+    return i;
+}
+
+/*
+ * Search for the first region ending after `addr` by descending the implicit
+ * Eytzinger tree. The descent is branch-free and cache-friendly because the
+ * top levels of the tree are packed at the beginning of the array.
+ */
+const struct region *region_table_find(struct region_table *table,
+                                       addr_t addr)
+{
+    size_t k;
+    if (table->index_generation != table->generation || !table->index) {
+        struct region_index_node *index;
+        size_t size = (table->size + 1) * sizeof(struct region_index_node);
+        if (!(index = realloc(table->index, size))) {
+            errf("target: out-of-memory for region index");
+            return NULL;
+        }
+        table->index = index;
+        region_index_fill(table, 0, 1);
+        table->index_generation = table->generation;
+    }
+
+    for (k = 1; k <= table->size; k = 2*k + (table->index[k].end <= addr));
+    while (k & 1) k >>= 1;
+    k >>= 1;
+    if (k && table->index[k].start <= addr)
+        return &table->regions[table->index[k].region];
+    return NULL;
 }
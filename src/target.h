@@ -5,6 +5,7 @@
 #include <sys/types.h>
 
 struct region;
+struct region_table;
 
 struct target {
     /* Detach target */
@@ -14,9 +15,18 @@ struct target {
     int (*stop)(struct target *);
     int (*run)(struct target *);
 
-    /* Iterate memory regions (iterate till the end to prevent memory leaks!) */
-    struct region *(*region_first)(struct target *);
-    struct region *(*region_next)(struct region *);
+    /* Frozen copy-on-write snapshot of a stopped target (or NULL) */
+    struct target *(*snapshot)(struct target *);
+
+    /* Memory region table (refreshed only when the memory map has changed) */
+    struct region_table *(*regions)(struct target *);
+
+    /*
+     * Residency of `len` bytes of memory pages at page-aligned `addr`. Fills
+     * `out` with MEM_PAGE_* flags for each page of target_page_size() bytes.
+     * Returns 0 if residency information is not available.
+     */
+    int (*pages)(struct target *, addr_t addr, size_t len, unsigned char *out);
 
     /* Read/write target memory */
     int (*read)(struct target *, addr_t addr, void *buf, size_t len);
@@ -30,6 +40,26 @@ struct target *target_attach(const char *uri);
 /* Destroy target instance */
 void target_detach(struct target *target);
 
+/*
+ * Wrap a target in a LRU cache of `pages` memory pages. Pages are cached only
+ * while the target is stopped, and the cache is emptied when the target runs.
+ * Detaching the cache target detaches the wrapped target as well.
+ */
+struct target *target_cache_new(struct target *target, size_t pages);
+
+/* Get page cache statistics of a target (returns 0 if not a cache target) */
+int target_cache_stats(struct target *target, size_t *size, size_t *capacity,
+                       unsigned long *hits, unsigned long *misses);
+
+/* Page size of targets (granularity of target->pages()) */
+size_t target_page_size();
+
+/* Page residency flags (neither flag set for never-touched pages) */
+enum mem_page_flags {
+    MEM_PAGE_PRESENT = 1,
+    MEM_PAGE_SWAPPED = 2
+};
+
 /* Memory region */
 struct region {
     addr_t start;
@@ -45,8 +75,55 @@ struct region {
 /* Represent region as a line of string */
 size_t region_snprint(const struct region *mr, char *out, size_t size);
 
-/* Copying and freeing regions iterated via target->region_{first,next}() */
-int region_copy(struct region *dest, const struct region *source);
-void region_destroy(struct region *region);
+/*
+ * Table of memory regions sorted by start address.
+ *
+ * Region paths are interned, i.e., equal paths share a single string that
+ * remains valid until the table is deleted. Every refresh of the table that
+ * changes the regions increments the generation and records the differences
+ * to the previous generation in `changes`.
+ */
+struct region_table {
+    struct region *regions;
+    size_t size, capacity;
+    unsigned long generation;
+
+    struct region_change {
+        enum region_change_type {
+            REGION_ADDED,
+            REGION_REMOVED,
+            REGION_RESIZED
+        } type;
+        struct region region;
+        addr_t old_size;
+    } *changes;
+    size_t changes_size, changes_capacity;
+
+    char **paths;
+    size_t paths_size, paths_capacity;
+
+    /* Interval index in Eytzinger order (rebuilt lazily for a generation) */
+    struct region_index_node {
+        addr_t start, end;
+        size_t region;
+    } *index;
+    unsigned long index_generation;
+};
+
+/* (De)allocate an empty region table */
+struct region_table *region_table_new();
+void region_table_delete(struct region_table *table);
+
+/* Replace table regions with an array of sorted regions (with any paths) */
+int region_table_update(struct region_table *table,
+                        const struct region *regions, size_t size);
+
+/* Replace table regions with regions parsed from /proc/pid/maps text */
+int region_table_parse_maps(struct region_table *table,
+                            const char *text, size_t len);
+
+/* Find region containing `addr` (or NULL) without refreshing the table */
+const struct region *region_table_find(struct region_table *table,
+                                       addr_t addr);
 
 #endif
@@ -111,6 +111,16 @@ int value_init_zero(struct value *dest, enum value_type type)
     return 1;
 }
 
+void value_data_swap(union value_data *data, size_t size)
+{
+    size_t i;
+    for (i = 0; i < size / 2; i++) {
+        char tmp = ((char *)data)[i];
+        ((char *)data)[i] = ((char *)data)[size-1 - i];
+        ((char *)data)[size-1 - i] = tmp;
+    }
+}
+
 int value_is_zero(const struct value *dest)
 {
     size_t i, j;
@@ -146,6 +156,12 @@ const char *value_type_to_string(enum value_type type)
     case F64: return "f64"; case F64PTR: return "f64*";
     #endif
 
+    case BE16: return "be16";
+    case BE32: return "be32";
+    #ifndef NO_64BIT_VALUES
+    case BE64: return "be64";
+    #endif
+
     default: break;
     }
     return "void";
@@ -284,10 +300,150 @@ enum value_type value_type_from_substring(const char *str, size_t len)
                 return F64 | mask;
 #endif
         }
+    } else if (j == len && i == 4 && !mask && str[0] == 'b' && str[1] == 'e') {
+        if (str[2] == '1' && str[3] == '6')
+            return BE16;
+        if (str[2] == '3' && str[3] == '2')
+            return BE32;
+        #ifndef NO_64BIT_VALUES
+        if (str[2] == '6' && str[3] == '4')
+            return BE64;
+        #endif
+    }
+
+    return 0;
+}
+
+#ifndef NO_FLOAT_VALUES
+/*
+ * Floating-point values mapped to integer keys ordered like the values, so
+ * that adjacent keys are adjacent representable values (-0.0 and +0.0 have
+ * the same key). Steps are saturated at the keys of the infinities.
+ */
+#define F32_INF_KEY INT32_C(0x7F800000)
+#define F64_INF_KEY INT64_C(0x7FF0000000000000)
+
+static int64_t f32_key(float x)
+{
+    int32_t i;
+    memcpy(&i, &x, sizeof(i));
+    return (i >= 0) ? i : INT32_MIN - (int64_t)i;
+}
+
+static float f32_step(float x, int64_t n)
+{
+    int64_t k = f32_key(x) + n;
+    int32_t i;
+    if (x != x)
+        return x;
+    if (k > F32_INF_KEY) k = F32_INF_KEY;
+    if (k < -F32_INF_KEY) k = -F32_INF_KEY;
+    i = (int32_t)((k >= 0) ? k : INT32_MIN - k);
+    memcpy(&x, &i, sizeof(x));
+    return x;
+}
+
+static double f64_step(double x, int64_t n)
+{
+    int64_t i, k;
+    if (x != x)
+        return x;
+    memcpy(&i, &x, sizeof(i));
+    k = (i >= 0) ? i : INT64_MIN - i;
+    if (n > 0) {
+        k = (k > F64_INF_KEY - n) ? F64_INF_KEY : k + n;
+    } else {
+        k = (k < -F64_INF_KEY - n) ? -F64_INF_KEY : k + n;
+    }
+    i = (k >= 0) ? k : INT64_MIN - k;
+    memcpy(&x, &i, sizeof(x));
+    return x;
+}
+
+/* Least f32 not less than x, and greatest f32 not greater than x */
+static float f32_ceil(double x)
+{
+    float f = (float)x;
+    return ((double)f < x) ? f32_step(f, 1) : f;
+}
+
+static float f32_floor(double x)
+{
+    float f = (float)x;
+    return ((double)f > x) ? f32_step(f, -1) : f;
+}
+
+int value_near_bounds(enum value_near mode, enum value_type type,
+                      struct value *center, struct value *tolerance,
+                      struct value *lo, struct value *hi)
+{
+    struct value c, t;
+    double l, h, half;
+    int64_t n;
+    long d;
+
+    if (!value_type_is_fpu(type) || !value_ops(center)->cast_to_f64(center, &c)
+            || !value_ops(tolerance)->cast_to_f64(tolerance, &t)) {
+        return 0;
+    }
+
+    switch (mode) {
+    case VALUE_NEAR_ABS:
+        l = c.data.f64 - t.data.f64;
+        h = c.data.f64 + t.data.f64;
+        break;
+
+    case VALUE_NEAR_ULPS:
+        if (!(t.data.f64 >= 0)) {
+            l = 1; /* empty */
+            h = 0;
+            break;
+        }
+        n = (t.data.f64 < F32_INF_KEY) ? (int64_t)t.data.f64 : F32_INF_KEY;
+        if (type == F32) {
+            float x = (float)c.data.f64;
+            value_init_f32(lo, f32_step(x, -n));
+            return value_init_f32(hi, f32_step(x, n));
+        }
+        n = (t.data.f64 < F64_INF_KEY) ? (int64_t)t.data.f64 : F64_INF_KEY;
+        value_init_f64(lo, f64_step(c.data.f64, -n));
+        return value_init_f64(hi, f64_step(c.data.f64, n));
+
+    case VALUE_NEAR_ROUND:
+        /* x rounds to c at d decimals: c - 0.5/10^d <= x < c + 0.5/10^d */
+        d = (t.data.f64 < -400) ? -400 : (t.data.f64 > 400) ? 400
+          : (long)t.data.f64;
+        for (half = 0.5; d > 0; d--) half /= 10;
+        for (; d < 0; d++) half *= 10;
+        l = c.data.f64 - half;
+        h = c.data.f64 + half;
+        if (type == F32) {
+            float f = f32_floor(h);
+            value_init_f32(lo, f32_ceil(l));
+            return value_init_f32(hi, ((double)f < h) ? f : f32_step(f, -1));
+        }
+        value_init_f64(lo, l);
+        return value_init_f64(hi, f64_step(h, -1));
+
+    default:
+        return 0;
     }
 
+    if (type == F32) {
+        value_init_f32(lo, f32_ceil(l));
+        return value_init_f32(hi, f32_floor(h));
+    }
+    value_init_f64(lo, l);
+    return value_init_f64(hi, h);
+}
+#else
+int value_near_bounds(enum value_near mode, enum value_type type,
+                      struct value *center, struct value *tolerance,
+                      struct value *lo, struct value *hi)
+{
     return 0;
 }
+#endif
 
 #ifndef NO_FLOAT_VALUES
 /*
@@ -13,6 +13,7 @@
 enum value_type {
     PTR = 0x10000000,
     ARR = 0x20000000,
+    BE  = 0x40000000, /* byte-swapped (big-endian) integer in the target */
 
     S8  = 0x00000001, S8PTR  = S8  | PTR,
     U8  = 0x00010001, U8PTR  = U8  | PTR,
@@ -35,6 +36,11 @@ enum value_type {
     FMAX = F64,
     #endif
 
+    BE16 = S16 | BE, BE32 = S32 | BE,
+    #ifndef NO_64BIT_VALUES
+    BE64 = S64 | BE,
+    #endif
+
     #if ADDR_BITS == 32
     ADDR = U32,
     #elif ADDR_BITS == 64
@@ -55,6 +61,8 @@ enum value_type {
 #define value_type_index(t) ((t) >> 16)
 #define value_type_sizeof(t) ((t) & 0xFF)
 #define value_type_is_int(t) ((t) <= UMAX)
+#define value_type_is_swapped(t) ((t) & BE)
+#define value_type_unswapped(t) ((enum value_type)((t) & ~BE))
 #ifndef NO_FLOAT_VALUES
 #define value_type_is_fpu(t) ((t) > UMAX && (t) <= FMAX)
 #else
@@ -157,6 +165,13 @@ int value_init_umax(struct value *dest, umax_t value);
 /* Initialize zero value of given type */
 int value_init_zero(struct value *dest, enum value_type type);
 
+/*
+ * Reverse the byte order of the first `size` bytes of `data`, e.g., to load
+ * and store values of byte-swapped types (which are otherwise operated on as
+ * values of the type without the BE flag).
+ */
+void value_data_swap(union value_data *data, size_t size);
+
 /* Check whether value is (non-)zero */
 int value_is_zero(const struct value *dest);
 #define value_is_nonzero(dest) (!value_is_zero((dest)))
@@ -171,4 +186,18 @@ size_t value_to_hexstring(const struct value *value, char *out, size_t size);
 /* Inverse of value_type_to_string() returning value type (or 0 on an error) */
 enum value_type value_type_from_substring(const char *str, size_t len);
 
+/*
+ * Approximate equality of floating-point values. Stores the least and the
+ * greatest value x of a floating-point type `type` (to `lo` and `hi`) with
+ *   VALUE_NEAR_ABS:   |x - center| <= tolerance
+ *   VALUE_NEAR_ULPS:  x at most `tolerance` representable values from center
+ *   VALUE_NEAR_ROUND: x rounding to center at `tolerance` decimal places
+ * so that approximate equality is a range test lo <= x && x <= hi (which is
+ * empty if lo > hi, or NaN if center is NaN). Returns 0 on error.
+ */
+enum value_near { VALUE_NEAR_ABS, VALUE_NEAR_ULPS, VALUE_NEAR_ROUND };
+int value_near_bounds(enum value_near mode, enum value_type type,
+                      struct value *center, struct value *tolerance,
+                      struct value *lo, struct value *hi);
+
 #endif